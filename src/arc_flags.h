@@ -0,0 +1,85 @@
+#ifndef ARC_FLAGS_H
+#define ARC_FLAGS_H
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <cassert>
+
+//! Derives a partition into cell_count cells from a nested dissection order.
+//! A nested dissection order places both sides of a separator into consecutive
+//! ranges before the separator. Cutting the order into equally sized ranges of
+//! consecutive ranks therefore yields cells that follow the dissection.
+inline
+std::vector<unsigned>compute_cell_of_node_from_order(const std::vector<unsigned>&order, unsigned cell_count){
+	const unsigned node_count = order.size();
+	std::vector<unsigned>cell_of_node(node_count);
+	for(unsigned r=0; r<node_count; ++r)
+		cell_of_node[order[r]] = static_cast<unsigned long long>(r)*cell_count/node_count;
+	return cell_of_node; // NVRO
+}
+
+//! A departure time t belongs to the time slot t*slot_count/period.
+inline
+unsigned compute_time_slot(unsigned period, unsigned slot_count, unsigned departure_time){
+	assert(departure_time < period);
+	return static_cast<unsigned long long>(departure_time)*slot_count/period;
+}
+
+//! Returns the first departure time of the given time slot. slot may be slot_count.
+inline
+unsigned compute_time_slot_begin(unsigned period, unsigned slot_count, unsigned slot){
+	return (static_cast<unsigned long long>(slot)*period + slot_count - 1)/slot_count;
+}
+
+inline
+unsigned compute_arc_flag_word_count_per_slot(unsigned cell_count){
+	return (cell_count + 31) / 32;
+}
+
+//! Stores for every arc, time slot and cell whether the arc can be part of a shortest path
+//! into the cell when its tail is left during the time slot. The flags of one arc and time slot
+//! form a bit vector with one bit per cell.
+class TimeDependentArcFlags{
+public:
+	TimeDependentArcFlags():period(0), cell_count(0), slot_count_(0), word_count_per_slot(0){}
+
+	TimeDependentArcFlags(unsigned period, unsigned arc_count, std::vector<unsigned>node_cell, std::vector<unsigned>arc_flag_word):
+		period(period), cell_of_node_(std::move(node_cell)), flag_word(std::move(arc_flag_word)){
+
+		if(cell_of_node_.empty())
+			throw std::runtime_error("there must be at least one node");
+		cell_count = *std::max_element(cell_of_node_.begin(), cell_of_node_.end()) + 1;
+		word_count_per_slot = compute_arc_flag_word_count_per_slot(cell_count);
+		if(arc_count == 0 || flag_word.size() % (static_cast<unsigned long long>(arc_count)*word_count_per_slot) != 0)
+			throw std::runtime_error("the number of arc flag words does not match the number of arcs and cells");
+		slot_count_ = flag_word.size() / (static_cast<unsigned long long>(arc_count)*word_count_per_slot);
+		if(slot_count_ == 0)
+			throw std::runtime_error("there must be at least one time slot");
+	}
+
+	unsigned cell_of_node(unsigned x)const{
+		return cell_of_node_[x];
+	}
+
+	unsigned slot_count()const{
+		return slot_count_;
+	}
+
+	//! departure_time must be smaller than the period
+	bool is_arc_flagged(unsigned arc, unsigned departure_time, unsigned target_cell)const{
+		unsigned slot = compute_time_slot(period, slot_count_, departure_time);
+		unsigned long long word = (static_cast<unsigned long long>(arc)*slot_count_ + slot)*word_count_per_slot + target_cell/32;
+		return (flag_word[word] >> (target_cell%32)) & 1;
+	}
+
+private:
+	unsigned period;
+	unsigned cell_count;
+	unsigned slot_count_;
+	unsigned word_count_per_slot;
+	std::vector<unsigned>cell_of_node_;
+	std::vector<unsigned>flag_word;
+};
+
+#endif
@@ -0,0 +1,306 @@
+#include "ipp.h"
+#include "dijkstra.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdlib>
+#include <cassert>
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+using namespace std;
+
+namespace{
+
+struct KernelResult{
+	string kernel;
+	double ns_per_op;
+	double stddev_ns_per_op;
+	unsigned repetitions;
+};
+
+// Results are accumulated into this variable so that the compiler cannot remove the benchmarked code.
+volatile unsigned long long sink;
+
+//! Runs f warmup_count times without measuring and then repetition_count times with measuring.
+//! f must perform op_count operations.
+template<class F>
+KernelResult measure_kernel(string kernel, unsigned long long op_count, unsigned warmup_count, unsigned repetition_count, const F&f){
+	for(unsigned i=0; i<warmup_count; ++i)
+		sink += f();
+
+	vector<double>ns_per_op(repetition_count);
+	for(unsigned i=0; i<repetition_count; ++i){
+		auto begin = chrono::steady_clock::now();
+		sink += f();
+		auto end = chrono::steady_clock::now();
+		ns_per_op[i] = chrono::duration<double, nano>(end - begin).count() / op_count;
+	}
+
+	double mean = 0;
+	for(auto x:ns_per_op)
+		mean += x;
+	mean /= repetition_count;
+	double variance = 0;
+	for(auto x:ns_per_op)
+		variance += (x-mean)*(x-mean);
+	if(repetition_count > 1)
+		variance /= repetition_count - 1;
+
+	return {move(kernel), mean, sqrt(variance), repetition_count};
+}
+
+const unsigned period = 24*60*60*1000;
+
+//! Generates arcs with a skewed IPP count distribution similar to real data:
+//! most arcs are constant and a few arcs have many IPPs.
+void generate_plfs(mt19937&random_generator, unsigned arc_count, vector<unsigned>&first_ipp_of_arc, vector<unsigned>&ipp_departure_time, vector<unsigned>&ipp_travel_time){
+	first_ipp_of_arc = {0};
+	ipp_departure_time.clear();
+	ipp_travel_time.clear();
+	vector<unsigned>departure_time;
+	for(unsigned a=0; a<arc_count; ++a){
+		unsigned r = random_generator() % 100;
+		unsigned ipp_count;
+		if(r < 50)
+			ipp_count = 1;
+		else if(r < 80)
+			ipp_count = 2 + random_generator() % 9;
+		else
+			ipp_count = 10 + random_generator() % 91;
+
+		departure_time.clear();
+		while(departure_time.size() < ipp_count){
+			departure_time.push_back(random_generator() % period);
+			sort(departure_time.begin(), departure_time.end());
+			departure_time.erase(unique(departure_time.begin(), departure_time.end()), departure_time.end());
+		}
+
+		unsigned base = 10000 + random_generator() % 200000;
+		for(auto t:departure_time){
+			ipp_departure_time.push_back(t);
+			ipp_travel_time.push_back(base + random_generator() % (base/4));
+		}
+		first_ipp_of_arc.push_back(ipp_departure_time.size());
+	}
+}
+
+vector<KernelResult>run_benchmarks(unsigned warmup_count, unsigned repetition_count){
+	vector<KernelResult>result;
+	mt19937 random_generator(42);
+
+	const unsigned arc_count = 100000;
+	vector<unsigned>first_ipp_of_arc, ipp_departure_time, ipp_travel_time;
+	generate_plfs(random_generator, arc_count, first_ipp_of_arc, ipp_departure_time, ipp_travel_time);
+
+	// Random arcs and departure times as seen by a Dijkstra search.
+	const unsigned op_count = 1000000;
+	vector<unsigned>query_arc(op_count), query_time(op_count);
+	for(unsigned i=0; i<op_count; ++i){
+		query_arc[i] = random_generator() % arc_count;
+		query_time[i] = random_generator() % period;
+	}
+
+	result.push_back(measure_kernel("evaluate_plf", op_count, warmup_count, repetition_count, [&]{
+		unsigned long long sum = 0;
+		for(unsigned i=0; i<op_count; ++i)
+			sum += evaluate_plf(ArcPLF(query_arc[i], period, first_ipp_of_arc, ipp_departure_time, ipp_travel_time), query_time[i]);
+		return sum;
+	}));
+
+	// Stabbing is used to sample a profile with increasing departure times.
+	const unsigned stab_arc_count = 1000;
+	const unsigned stab_sample_count = op_count / stab_arc_count;
+	result.push_back(measure_kernel("evaluate_plf_with_stabing", stab_arc_count*stab_sample_count, warmup_count, repetition_count, [&]{
+		unsigned long long sum = 0;
+		for(unsigned a=0; a<stab_arc_count; ++a){
+			ArcPLF plf(query_arc[a], period, first_ipp_of_arc, ipp_departure_time, ipp_travel_time);
+			unsigned stab_ipp = 0;
+			for(unsigned i=0; i<stab_sample_count; ++i)
+				sum += evaluate_plf_with_stabing(plf, static_cast<unsigned long long>(i)*period/stab_sample_count, stab_ipp);
+		}
+		return sum;
+	}));
+
+	const unsigned integral_op_count = op_count / 10;
+	result.push_back(measure_kernel("integral_of_plf", integral_op_count, warmup_count, repetition_count, [&]{
+		unsigned long long sum = 0;
+		for(unsigned i=0; i<integral_op_count; ++i){
+			// Time windows as used for the TD-S preprocessing are a few hours long.
+			unsigned begin = query_time[i];
+			unsigned end = (begin + 4*60*60*1000) % period;
+			sum += integral_of_plf(ArcPLF(query_arc[i], period, first_ipp_of_arc, ipp_departure_time, ipp_travel_time), begin, end);
+		}
+		return sum;
+	}));
+
+	// The queue and the node state are benchmarked through Dijkstra on synthetic graphs, so that
+	// exactly the code of the searches is measured. Without arcs settling a node only pops it.
+	auto no_weight = [](unsigned, unsigned){return inf_weight;};
+
+	for(unsigned heap_size : {1000u, 100000u}){
+		vector<unsigned>key(heap_size);
+		for(auto&k:key)
+			k = random_generator() % period;
+
+		vector<unsigned>no_arc_first_out(heap_size+1, 0), no_arc_head;
+		Dijkstra queue(no_arc_first_out, no_arc_head);
+
+		result.push_back(measure_kernel("Dijkstra queue push+pop heap_size=" + to_string(heap_size), heap_size, warmup_count, repetition_count, [&]{
+			queue.clear();
+			for(unsigned i=0; i<heap_size; ++i)
+				queue.add_source_node(i, key[i]);
+			unsigned long long sum = 0;
+			while(!queue.is_finished())
+				sum += queue.settle(no_weight).key;
+			return sum;
+		}));
+
+		// Node 0 has an arc to every other node. Settling it decreases the keys of all other
+		// nodes. The arcs are shuffled, so that the keys are decreased in a random order as it
+		// happens in a Dijkstra search.
+		vector<unsigned>star_first_out(heap_size+1, heap_size-1), star_head(heap_size-1);
+		star_first_out[0] = 0;
+		for(unsigned i=1; i<heap_size; ++i)
+			star_head[i-1] = i;
+		shuffle(star_head.begin(), star_head.end(), random_generator);
+		Dijkstra star(star_first_out, star_head);
+
+		result.push_back(measure_kernel("Dijkstra queue decrease_key heap_size=" + to_string(heap_size), heap_size, warmup_count, repetition_count, [&]{
+			star.clear();
+			for(unsigned i=1; i<heap_size; ++i)
+				star.add_source_node(i, key[i] + period);
+			star.add_source_node(0, 0);
+			return star.settle([&](unsigned arc, unsigned){return key[star_head[arc]];}).key;
+		}));
+	}
+
+	{
+		const unsigned node_count = 1000000;
+		vector<unsigned>touched(1000);
+		for(auto&x:touched)
+			x = random_generator() % node_count;
+		sort(touched.begin(), touched.end());
+		touched.erase(unique(touched.begin(), touched.end()), touched.end());
+
+		vector<unsigned>no_arc_first_out(node_count+1, 0), no_arc_head;
+		Dijkstra dij(no_arc_first_out, no_arc_head);
+
+		// A small search touches few nodes and then the search is cleared. All nodes get the
+		// same key, so that the queue does not reorder anything.
+		result.push_back(measure_kernel("Dijkstra node state clear+add_source_node+distance_to", touched.size(), warmup_count, repetition_count, [&]{
+			unsigned long long sum = 0;
+			for(unsigned round=0; round<100; ++round){
+				dij.clear();
+				for(auto x:touched)
+					dij.add_source_node(x, 0);
+				for(auto x:touched)
+					sum += dij.distance_to(x);
+			}
+			return sum;
+		}));
+		result.back().ns_per_op /= 100;
+		result.back().stddev_ns_per_op /= 100;
+	}
+
+	return result;
+}
+
+void save_results(ostream&out, const vector<KernelResult>&result){
+	out << "kernel,ns_per_op,stddev_ns_per_op,repetitions\n";
+	for(auto&r:result)
+		out << r.kernel << ',' << r.ns_per_op << ',' << r.stddev_ns_per_op << ',' << r.repetitions << '\n';
+}
+
+map<string, KernelResult>load_results(const string&file_name){
+	ifstream in(file_name);
+	if(!in)
+		throw runtime_error("Can not open \""+file_name+"\" for reading.");
+	map<string, KernelResult>result;
+	string line;
+	getline(in, line); // header
+	while(getline(in, line)){
+		if(line.empty())
+			continue;
+		istringstream line_in(line);
+		KernelResult r;
+		string ns_per_op, stddev_ns_per_op, repetitions;
+		if(!getline(line_in, r.kernel, ',') || !getline(line_in, ns_per_op, ',') || !getline(line_in, stddev_ns_per_op, ',') || !getline(line_in, repetitions, ','))
+			throw runtime_error("Invalid line \""+line+"\" in \""+file_name+"\".");
+		r.ns_per_op = stod(ns_per_op);
+		r.stddev_ns_per_op = stod(stddev_ns_per_op);
+		r.repetitions = stoul(repetitions);
+		result[r.kernel] = r;
+	}
+	return result;
+}
+
+}
+
+int main(int argc, char*argv[]){
+	try{
+		if(argc >= 2 && string(argv[1]) == "compare"){
+			if(argc != 4 && argc != 5){
+				cerr << "Usage : " << argv[0] << " compare old_result new_result [max_slowdown_percent]" << endl;
+				return 1;
+			}
+			double max_slowdown = argc == 5 ? stod(argv[4]) : 5.0;
+			auto old_result = load_results(argv[2]);
+			auto new_result = load_results(argv[3]);
+
+			// A kernel regressed if it is slower by more than max_slowdown percent
+			// and the difference is larger than the measurement noise.
+			bool has_regression = false;
+			cout << "kernel,old_ns_per_op,new_ns_per_op,change_percent,verdict\n";
+			for(auto&n:new_result){
+				auto o = old_result.find(n.first);
+				if(o == old_result.end()){
+					cout << n.first << ",," << n.second.ns_per_op << ",,new\n";
+					continue;
+				}
+				double change = 100.0*(n.second.ns_per_op - o->second.ns_per_op)/o->second.ns_per_op;
+				double noise = 2*(n.second.stddev_ns_per_op + o->second.stddev_ns_per_op);
+				bool is_regression = change > max_slowdown && n.second.ns_per_op - o->second.ns_per_op > noise;
+				has_regression |= is_regression;
+				cout << n.first << ',' << o->second.ns_per_op << ',' << n.second.ns_per_op << ',' << change << ',' << (is_regression ? "regression" : "ok") << '\n';
+			}
+			for(auto&o:old_result)
+				if(!new_result.count(o.first))
+					cout << o.first << ',' << o.second.ns_per_op << ",,,removed\n";
+			cout << flush;
+			return has_regression ? 1 : 0;
+		}
+
+		if(argc > 4){
+			cerr
+				<< "Usage : \n"
+				<< argv[0] << " [output_file [repetition_count [warmup_count]]]\n"
+				<< argv[0] << " compare old_result new_result [max_slowdown_percent]" << endl;
+			return 1;
+		}
+
+		unsigned repetition_count = argc >= 3 ? stoul(argv[2]) : 10;
+		unsigned warmup_count = argc >= 4 ? stoul(argv[3]) : 2;
+		if(repetition_count == 0)
+			throw runtime_error("repetition count must not be zero");
+
+		auto result = run_benchmarks(warmup_count, repetition_count);
+		save_results(cout, result);
+		if(argc >= 2){
+			ofstream out(argv[1]);
+			if(!out)
+				throw runtime_error(string("Can not open \"")+argv[1]+"\" for writing.");
+			save_results(out, result);
+		}
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+		return 1;
+	}
+}
@@ -0,0 +1,110 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/inverse_vector.h>
+#include <routingkit/contraction_hierarchy.h>
+#include <routingkit/timer.h>
+
+#include "verify.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cassert>
+#include <exception>
+
+using namespace std;
+using namespace RoutingKit;
+
+int main(int argc, char*argv[]){
+	try{
+		vector<unsigned>first_out, head;
+		vector<vector<unsigned>>weight;
+		vector<string>ch_file;
+
+		// If set, only the first CH computes a contraction order and all other CHs reuse it.
+		bool reuse_order = false;
+
+		vector<string>file_list;
+		for(int i=1; i<argc; ++i){
+			string arg = argv[i];
+			if(arg == "--reuse-order")
+				reuse_order = true;
+			else
+				file_list.push_back(move(arg));
+		}
+
+		if(file_list.size() < 4 || file_list.size() % 2 != 0){
+			cerr
+				<< "Usage : \n"
+				<< argv[0] << " [--reuse-order] first_out head weight1 output_ch1 [weight2 output_ch2 [...]]\n"
+				<< "Example : " << argv[0] << " input/{first_out,head} win4/0_5 ch4/0_5 win4/6_9 ch4/6_9 win4/11_14 ch4/11_14 win4/16_19 ch4/16_19" << endl;
+			return 1;
+		}else{
+			cout << "Loading ... " << flush;
+			first_out = load_vector<unsigned>(file_list[0]);
+			head = load_vector<unsigned>(file_list[1]);
+			for(unsigned i=2; i<file_list.size(); i+=2){
+				weight.push_back(load_vector<unsigned>(file_list[i]));
+				ch_file.push_back(file_list[i+1]);
+			}
+			cout << "done" << endl;
+		}
+
+		cout << "Validity tests ... " << flush;
+		check_if_graph_is_valid(first_out, head);
+		for(auto&w:weight)
+			if(w.size() != head.size())
+				throw runtime_error("weight has wrong size");
+		cout << "done" << endl;
+
+		const unsigned node_count = first_out.size()-1;
+		const unsigned ch_count = weight.size();
+		const vector<unsigned>tail = invert_inverse_vector(first_out);
+
+		vector<long long>ch_timer(ch_count, 0);
+		vector<unsigned>rank;
+
+		cout << "Building " << ch_count << " CHs ... " << flush;
+		long long timer = -get_micro_time();
+		unsigned first_parallel_ch = 0;
+		if(reuse_order){
+			ch_timer[0] = -get_micro_time();
+			ContractionHierarchy ch = ContractionHierarchy::build(node_count, tail, head, weight[0]);
+			ch_timer[0] += get_micro_time();
+			ch.save_file(ch_file[0]);
+			rank = ch.rank;
+			first_parallel_ch = 1;
+		}
+
+		// Every thread saves and frees its CH before building the next one. An exception must not
+		// leave the parallel region. The first one is therefore stored and rethrown after the region.
+		exception_ptr error;
+		#pragma omp parallel for schedule(dynamic, 1)
+		for(unsigned i=first_parallel_ch; i<ch_count; ++i){
+			try{
+				ch_timer[i] = -get_micro_time();
+				ContractionHierarchy ch = reuse_order
+					? ContractionHierarchy::build_given_rank(rank, tail, head, weight[i])
+					: ContractionHierarchy::build(node_count, tail, head, weight[i]);
+				ch_timer[i] += get_micro_time();
+				ch.save_file(ch_file[i]);
+			}catch(...){
+				#pragma omp critical
+				if(!error)
+					error = current_exception();
+			}
+		}
+		if(error)
+			rethrow_exception(error);
+		timer += get_micro_time();
+		cout << "done" << endl;
+
+		for(unsigned i=0; i<ch_count; ++i)
+			cout << ch_file[i] << " running time [musec] : " << ch_timer[i] << '\n';
+		cout << "total running time [musec] : " << timer << endl;
+
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+	}
+}
@@ -0,0 +1,132 @@
+#ifndef CH_ONE_TO_MANY_H
+#define CH_ONE_TO_MANY_H
+
+#include <routingkit/contraction_hierarchy.h>
+#include <routingkit/inverse_vector.h>
+
+#include "dijkstra.h"
+
+#include <vector>
+#include <cassert>
+
+//! Computes the shortest paths in a CH from one source to many targets. This works like pin_targets and
+//! run_to_pinned_targets of RoutingKit's ContractionHierarchyQuery, which however only report the
+//! distances. The upward search spaces of the targets are computed once when they are pinned. Every
+//! source then needs a single upward search, and the meeting node of each target is found by scanning
+//! the target's search space. The paths are unpacked into arcs of the input graph.
+class ContractionHierarchyOneToManyQuery{
+public:
+	explicit ContractionHierarchyOneToManyQuery(const RoutingKit::ContractionHierarchy&ch):
+		ch(&ch),
+		forward_dij(ch.forward.first_out, ch.forward.head),
+		backward_dij(ch.backward.first_out, ch.backward.head),
+		backward_tail(RoutingKit::invert_inverse_vector(ch.backward.first_out)),
+		entry_of_node(ch.node_count(), invalid_id){}
+
+	void pin_targets(const std::vector<unsigned>&target_list){
+		first_entry_of_target = {0};
+		entry.clear();
+		std::vector<IDKeyPair>reached;
+		for(auto t:target_list){
+			assert(t < ch->node_count());
+			backward_dij.run_until(ch->rank[t], 0, inf_weight, reached, [&](unsigned arc, unsigned){return ch->backward.weight[arc];});
+			unsigned first_entry = entry.size();
+			for(auto x:reached){
+				unsigned parent = invalid_id, arc = invalid_id;
+				if(x.id != ch->rank[t]){
+					arc = backward_dij.arc_path_to(x.id).back();
+					parent = entry_of_node[backward_tail[arc]];
+				}
+				entry_of_node[x.id] = entry.size();
+				entry.push_back({x.id, x.key, parent, arc});
+			}
+			for(unsigned i=first_entry; i<entry.size(); ++i)
+				entry_of_node[entry[i].node] = invalid_id;
+			first_entry_of_target.push_back(entry.size());
+		}
+		meeting_entry.resize(target_list.size());
+		distance.resize(target_list.size());
+	}
+
+	unsigned pinned_target_count()const{
+		return meeting_entry.size();
+	}
+
+	//! Computes the distances and meeting nodes from source_node to all pinned targets.
+	void run(unsigned source_node){
+		assert(source_node < ch->node_count());
+		forward_dij.run(ch->rank[source_node], 0, invalid_id, [&](unsigned arc, unsigned){return ch->forward.weight[arc];});
+		for(unsigned i=0; i<pinned_target_count(); ++i){
+			meeting_entry[i] = invalid_id;
+			distance[i] = inf_weight;
+			for(unsigned j=first_entry_of_target[i]; j<first_entry_of_target[i+1]; ++j){
+				unsigned d = forward_dij.distance_to(entry[j].node);
+				if(d != inf_weight && d + entry[j].distance < distance[i]){
+					distance[i] = d + entry[j].distance;
+					meeting_entry[i] = j;
+				}
+			}
+		}
+	}
+
+	//! Returns the distance to the i-th pinned target or inf_weight if it is unreachable.
+	unsigned get_distance(unsigned i)const{
+		return distance[i];
+	}
+
+	//! Returns the path to the i-th pinned target as IDs of input arcs.
+	std::vector<unsigned>get_arc_path(unsigned i)const{
+		std::vector<unsigned>path;
+		if(meeting_entry[i] == invalid_id)
+			return path;
+		auto on_input_arc = [&](unsigned arc){path.push_back(arc);};
+		for(auto a:forward_dij.arc_path_to(entry[meeting_entry[i]].node))
+			unpack_forward_arc(a, on_input_arc);
+		// Every backward arc leads from the meeting node one step closer to the target.
+		for(unsigned j=meeting_entry[i]; entry[j].parent != invalid_id; j=entry[j].parent)
+			unpack_backward_arc(entry[j].arc, on_input_arc);
+		return path; // NVRO
+	}
+
+private:
+	template<class OnInputArc>
+	void unpack_forward_arc(unsigned arc, const OnInputArc&on_input_arc)const{
+		if(ch->forward.is_shortcut_an_original_arc.is_set(arc)){
+			on_input_arc(ch->forward.shortcut_first_arc[arc]);
+		}else{
+			unpack_backward_arc(ch->forward.shortcut_first_arc[arc], on_input_arc);
+			unpack_forward_arc(ch->forward.shortcut_second_arc[arc], on_input_arc);
+		}
+	}
+
+	template<class OnInputArc>
+	void unpack_backward_arc(unsigned arc, const OnInputArc&on_input_arc)const{
+		if(ch->backward.is_shortcut_an_original_arc.is_set(arc)){
+			on_input_arc(ch->backward.shortcut_first_arc[arc]);
+		}else{
+			unpack_backward_arc(ch->backward.shortcut_first_arc[arc], on_input_arc);
+			unpack_forward_arc(ch->backward.shortcut_second_arc[arc], on_input_arc);
+		}
+	}
+
+	//! A node in the upward search space of a target, the distance from it to the target, and
+	//! the backward arc leading to the parent entry, which is one step closer to the target.
+	struct Entry{
+		unsigned node;
+		unsigned distance;
+		unsigned parent;
+		unsigned arc;
+	};
+
+	const RoutingKit::ContractionHierarchy*ch;
+	Dijkstra forward_dij, backward_dij;
+	std::vector<unsigned>backward_tail;
+	std::vector<unsigned>entry_of_node;
+
+	//! The search space of the i-th target is entry[first_entry_of_target[i]], ..., entry[first_entry_of_target[i+1]-1].
+	std::vector<unsigned>first_entry_of_target;
+	std::vector<Entry>entry;
+	std::vector<unsigned>meeting_entry, distance;
+};
+
+#endif
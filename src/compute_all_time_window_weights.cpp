@@ -0,0 +1,94 @@
+#include "ipp.h"
+#include "verify.h"
+
+#include <routingkit/vector_io.h>
+#include <routingkit/timer.h>
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cassert>
+
+using namespace std;
+using namespace RoutingKit;
+
+int main(int argc, char*argv[]){
+	try{
+		const unsigned period = 24*60*60*1000;
+		vector<unsigned>first_ipp_of_arc;
+		vector<unsigned>ipp_departure_time;
+		vector<unsigned>ipp_travel_time;
+
+		string min_weight_file, max_weight_file;
+		vector<unsigned>window_begin, window_end;
+		vector<string>window_weight_file;
+
+		if(argc < 6 || (argc-6) % 3 != 0){
+			cerr << argv[0] << " first_ipp_of_arc_file ipp_departure_time_file ipp_travel_time_file min_weight_file max_weight_file [window_begin window_end weight_file]...\n"
+				<< "Usage: " << argv[0] << " td/{first_ipp_of_arc,ipp_departure_time,ipp_travel_time} freeflow max "
+				<< 0 << " " << 5*60*60*1000 << " win4/0_5 " << 6*60*60*1000 << " " << 9*60*60*1000 << " win4/6_9\n"
+				<< "window_begin and window_end are in milliseconds since the begin of the day. The min weights are the freeflow weights." << endl;
+			return 1;
+		} else {
+			cout << "Loading ... " << flush;
+			first_ipp_of_arc = load_vector<unsigned>(argv[1]);
+			ipp_departure_time = load_vector<unsigned>(argv[2]);
+			ipp_travel_time = load_vector<unsigned>(argv[3]);
+			min_weight_file = argv[4];
+			max_weight_file = argv[5];
+			for(int i=6; i<argc; i+=3){
+				window_begin.push_back(stoul(argv[i]));
+				window_end.push_back(stoul(argv[i+1]));
+				window_weight_file.push_back(argv[i+2]);
+			}
+			cout << "done" << endl;
+		}
+
+		const unsigned window_count = window_begin.size();
+
+		cout << "Validity tests ... " << flush;
+		for(unsigned w=0; w<window_count; ++w){
+			if(window_end[w] <= window_begin[w])
+				throw runtime_error("window begin must be before window end");
+			if(period < window_end[w])
+				throw runtime_error("window end must be smaller than the period");
+		}
+		check_if_arc_ipp_are_valid(period, first_ipp_of_arc, ipp_departure_time, ipp_travel_time);
+		cout << "done" << endl;
+
+		cout << "Computing weights ... " << flush;
+		long long timer = -get_micro_time();
+		const unsigned arc_count = first_ipp_of_arc.size()-1;
+		vector<unsigned>min_weight(arc_count), max_weight(arc_count);
+		vector<vector<unsigned>>window_weight(window_count, vector<unsigned>(arc_count));
+
+		// Every arc's IPPs are loaded once and stay in the cache while all weights of the arc are computed.
+		#pragma omp parallel for schedule(dynamic, 4096)
+		for(unsigned a=0; a<arc_count; ++a){
+			ArcPLF plf(a, period, first_ipp_of_arc, ipp_departure_time, ipp_travel_time);
+			min_weight[a] = minimum_of_plf(plf);
+			max_weight[a] = maximum_of_plf(plf);
+			for(unsigned w=0; w<window_count; ++w)
+				window_weight[w][a] = integral_of_plf(plf, window_begin[w], window_end[w]) / (window_end[w] - window_begin[w]);
+		}
+		timer += get_micro_time();
+		cout << "done" << endl;
+
+		cout
+			<< "arc count : " << arc_count << '\n'
+			<< "window count : " << window_count << '\n'
+			<< "running time [musec] : " << timer << endl;
+
+		cout << "Saving ... " << flush;
+		save_vector(min_weight_file, min_weight);
+		save_vector(max_weight_file, max_weight);
+		for(unsigned w=0; w<window_count; ++w)
+			save_vector(window_weight_file[w], window_weight[w]);
+		cout << "done" << endl;
+
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+	}
+}
@@ -0,0 +1,55 @@
+#include "ipp.h"
+#include "verify.h"
+
+#include <routingkit/vector_io.h>
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cassert>
+
+using namespace std;
+using namespace RoutingKit;
+
+int main(int argc, char*argv[]){
+	try{
+		const unsigned period = 24*60*60*1000;
+		vector<unsigned>first_ipp_of_arc;
+		vector<unsigned>ipp_departure_time;
+		vector<unsigned>ipp_travel_time;
+
+		string prefix_file;
+
+		if(argc != 5){
+			cerr << argv[0] << " first_ipp_of_arc_file ipp_departure_time_file ipp_travel_time_file ipp_prefix_integral_file\n"
+				<< "Usage: " << argv[0] << " td/{first_ipp_of_arc,ipp_departure_time,ipp_travel_time} td/ipp_prefix_integral" << endl;
+			return 1;
+		} else {
+			cout << "Loading ... " << flush;
+			first_ipp_of_arc = load_vector<unsigned>(argv[1]);
+			ipp_departure_time = load_vector<unsigned>(argv[2]);
+			ipp_travel_time = load_vector<unsigned>(argv[3]);
+			prefix_file = argv[4];
+			cout << "done" << endl;
+		}
+
+		cout << "Validity tests ... " << flush;
+		check_if_arc_ipp_are_valid(period, first_ipp_of_arc, ipp_departure_time, ipp_travel_time);
+		cout << "done" << endl;
+
+		cout << "Computing prefix integrals ... " << flush;
+		vector<unsigned long long>prefix = compute_ipp_prefix_integral_times_two(
+			period, first_ipp_of_arc, ipp_departure_time, ipp_travel_time
+		);
+		cout << "done" << endl;
+
+		cout << "Saving ... " << flush;
+		save_vector(prefix_file, prefix);
+		cout << "done" << endl;
+
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+	}
+}
@@ -0,0 +1,238 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/inverse_vector.h>
+#include <routingkit/permutation.h>
+#include <routingkit/timer.h>
+
+#include "ipp.h"
+#include "dijkstra.h"
+#include "reverse_graph.h"
+#include "arc_flags.h"
+#include "verify.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cassert>
+
+using namespace std;
+using namespace RoutingKit;
+
+int main(int argc, char*argv[]){
+	try{
+		const unsigned period = 24*60*60*1000;
+		vector<unsigned>first_out, head, first_ipp_of_arc, ipp_departure_time, ipp_travel_time;
+		vector<unsigned>cch_order;
+		unsigned cell_count, slot_count;
+		unsigned horizon = 0;
+
+		vector<string>file_list;
+		for(int i=1; i<argc; ++i){
+			string arg = argv[i];
+			if(arg == "--horizon" && i+1 < argc)
+				horizon = stoul(argv[++i]);
+			else
+				file_list.push_back(move(arg));
+		}
+
+		if(file_list.size() != 10){
+			cerr
+				<< "Usage : \n"
+				<< argv[0] << " [--horizon ms] first_out head first_ipp_of_arc ipp_departure_time ipp_travel_time cch_order cell_count slot_count output_cell output_arc_flags\n"
+				<< "Example : " << argv[0] << " input/{first_out,head,first_ipp_of_arc,ipp_departure_time,ipp_travel_time} cch_order 64 24 cell arc_flags\n"
+				<< "The bounds of a time slot are computed for the departure times up to horizon after the slot. The default horizon is the slot length." << endl;
+			return 1;
+		}else{
+			cout << "Loading ... " << flush;
+			first_out = load_vector<unsigned>(file_list[0]);
+			head = load_vector<unsigned>(file_list[1]);
+			first_ipp_of_arc = load_vector<unsigned>(file_list[2]);
+			ipp_departure_time = load_vector<unsigned>(file_list[3]);
+			ipp_travel_time = load_vector<unsigned>(file_list[4]);
+			cch_order = load_vector<unsigned>(file_list[5]);
+			cell_count = stoul(file_list[6]);
+			slot_count = stoul(file_list[7]);
+			cout << "done" << endl;
+		}
+
+		cout << "Validity tests ... " << flush;
+		check_if_td_graph_is_valid(period, first_out, head, first_ipp_of_arc, ipp_departure_time, ipp_travel_time);
+
+		const unsigned node_count = first_out.size()-1;
+		const unsigned arc_count = head.size();
+
+		if(cch_order.size() != node_count)
+			throw runtime_error("CCH order has wrong size");
+		if(!is_permutation(cch_order))
+			throw runtime_error("CCH order is no permutation");
+		if(cell_count == 0 || cell_count > node_count)
+			throw runtime_error("cell count must be between 1 and the node count");
+		if(slot_count == 0 || slot_count > period)
+			throw runtime_error("slot count must be between 1 and the period");
+		if(horizon == 0)
+			horizon = compute_time_slot_begin(period, slot_count, 1);
+		cout << "done" << endl;
+
+		cout << "Computing cells ... " << flush;
+		vector<unsigned>cell_of_node = compute_cell_of_node_from_order(cch_order, cell_count);
+		vector<unsigned>first_node_of_cell(cell_count+1, 0), node_of_cell(node_count);
+		for(auto c:cell_of_node)
+			++first_node_of_cell[c+1];
+		for(unsigned c=0; c<cell_count; ++c)
+			first_node_of_cell[c+1] += first_node_of_cell[c];
+		{
+			vector<unsigned>next = first_node_of_cell;
+			for(unsigned x=0; x<node_count; ++x)
+				node_of_cell[next[cell_of_node[x]]++] = x;
+		}
+		cout << "done" << endl;
+
+		cout << "Computing bounds ... " << flush;
+		ReverseGraph reverse_graph = compute_reverse_graph(first_out, head);
+		vector<unsigned>tail = invert_inverse_vector(first_out);
+		vector<unsigned>min_weight = compute_min_weights(period, first_ipp_of_arc, ipp_departure_time, ipp_travel_time);
+		vector<unsigned>max_weight = compute_max_weights(period, first_ipp_of_arc, ipp_departure_time, ipp_travel_time);
+
+		// A path that departs during a time slot and takes at most horizon to reach a boundary node
+		// departs all its arcs during the window that starts with the slot and ends horizon after it.
+		// The window bounds are therefore valid for such paths. The whole day bounds are used for the others.
+		vector<unsigned>slot_min_weight(static_cast<unsigned long long>(arc_count)*slot_count);
+		vector<unsigned>window_min_weight(static_cast<unsigned long long>(arc_count)*slot_count);
+		vector<unsigned>window_max_weight(static_cast<unsigned long long>(arc_count)*slot_count);
+		for(unsigned a=0; a<arc_count; ++a){
+			ArcPLF plf(a, period, first_ipp_of_arc, ipp_departure_time, ipp_travel_time);
+			for(unsigned s=0; s<slot_count; ++s){
+				unsigned long long i = static_cast<unsigned long long>(a)*slot_count + s;
+				unsigned slot_begin = compute_time_slot_begin(period, slot_count, s);
+				unsigned slot_end = compute_time_slot_begin(period, slot_count, s+1);
+				slot_min_weight[i] = minimum_of_plf_in_window(plf, slot_begin, slot_end % period);
+				unsigned long long window_end = static_cast<unsigned long long>(slot_end) + horizon;
+				if(window_end - slot_begin >= period){
+					window_min_weight[i] = min_weight[a];
+					window_max_weight[i] = max_weight[a];
+				}else{
+					window_min_weight[i] = minimum_of_plf_in_window(plf, slot_begin, window_end % period);
+					window_max_weight[i] = maximum_of_plf_in_window(plf, slot_begin, window_end % period);
+				}
+			}
+		}
+		cout << "done" << endl;
+
+		cout << "Computing arc flags ... " << flush;
+		long long timer = -get_micro_time();
+		const unsigned word_count_per_slot = compute_arc_flag_word_count_per_slot(cell_count);
+		vector<unsigned>flag_word(static_cast<unsigned long long>(arc_count)*slot_count*word_count_per_slot, 0);
+		unsigned long long boundary_node_count = 0;
+
+		// An arc u->v with u outside of the cell can only be on a shortest path into the cell
+		// when leaving u during a time slot, if for some boundary node b of the cell
+		//   slot_min_weight(u->v) + lower_dist(v, b) <= upper_dist(u, b)
+		// holds. Arcs with their tail inside the cell are always flagged. The distances are bounded
+		// per time slot using the window weights. A window lower bound above the horizon only shows
+		// that the path takes longer than the horizon, and a window upper bound above the horizon is
+		// invalid. In both cases the whole day bound is used.
+		#pragma omp parallel
+		{
+			Dijkstra day_lower_dij(reverse_graph.first_out, reverse_graph.head);
+			Dijkstra day_upper_dij(reverse_graph.first_out, reverse_graph.head);
+			Dijkstra lower_dij(reverse_graph.first_out, reverse_graph.head);
+			Dijkstra upper_dij(reverse_graph.first_out, reverse_graph.head);
+			vector<bool>is_flagged(static_cast<unsigned long long>(arc_count)*slot_count);
+
+			auto get_min_weight = [&](unsigned back_arc, unsigned){
+				return min_weight[reverse_graph.forward_arc[back_arc]];
+			};
+			auto get_max_weight = [&](unsigned back_arc, unsigned){
+				return max_weight[reverse_graph.forward_arc[back_arc]];
+			};
+
+			#pragma omp for schedule(dynamic) reduction(+:boundary_node_count)
+			for(unsigned c=0; c<cell_count; ++c){
+				fill(is_flagged.begin(), is_flagged.end(), false);
+
+				for(unsigned i=first_node_of_cell[c]; i<first_node_of_cell[c+1]; ++i){
+					unsigned x = node_of_cell[i];
+					for(unsigned a=first_out[x]; a<first_out[x+1]; ++a)
+						for(unsigned s=0; s<slot_count; ++s)
+							is_flagged[static_cast<unsigned long long>(a)*slot_count + s] = true;
+				}
+
+				for(unsigned i=first_node_of_cell[c]; i<first_node_of_cell[c+1]; ++i){
+					unsigned b = node_of_cell[i];
+
+					bool is_boundary_node = false;
+					for(unsigned back_arc=reverse_graph.first_out[b]; back_arc<reverse_graph.first_out[b+1]; ++back_arc)
+						if(cell_of_node[reverse_graph.head[back_arc]] != c)
+							is_boundary_node = true;
+					if(!is_boundary_node)
+						continue;
+					++boundary_node_count;
+
+					day_lower_dij.run(b, 0, invalid_id, get_min_weight);
+					day_upper_dij.run(b, 0, invalid_id, get_max_weight);
+
+					for(unsigned s=0; s<slot_count; ++s){
+						lower_dij.run(b, 0, invalid_id, [&](unsigned back_arc, unsigned){
+							return window_min_weight[static_cast<unsigned long long>(reverse_graph.forward_arc[back_arc])*slot_count + s];
+						});
+						upper_dij.run(b, 0, invalid_id, [&](unsigned back_arc, unsigned){
+							return window_max_weight[static_cast<unsigned long long>(reverse_graph.forward_arc[back_arc])*slot_count + s];
+						});
+
+						for(unsigned a=0; a<arc_count; ++a){
+							if(cell_of_node[tail[a]] == c)
+								continue;
+							unsigned day_lower = day_lower_dij.distance_to(head[a]);
+							unsigned day_upper = day_upper_dij.distance_to(tail[a]);
+							if(day_lower == inf_weight || day_upper == inf_weight)
+								continue;
+
+							unsigned long long i = static_cast<unsigned long long>(a)*slot_count + s;
+							unsigned long long lower = max(
+								min(static_cast<unsigned long long>(slot_min_weight[i]) + lower_dij.distance_to(head[a]), static_cast<unsigned long long>(horizon)),
+								static_cast<unsigned long long>(slot_min_weight[i]) + day_lower
+							);
+							unsigned upper = upper_dij.distance_to(tail[a]);
+							if(upper > horizon)
+								upper = day_upper;
+
+							if(lower <= upper)
+								is_flagged[i] = true;
+						}
+					}
+				}
+
+				#pragma omp critical
+				{
+					for(unsigned long long i=0; i<is_flagged.size(); ++i)
+						if(is_flagged[i])
+							flag_word[i*word_count_per_slot + c/32] |= (1u << (c%32));
+				}
+			}
+		}
+		timer += get_micro_time();
+		cout << "done" << endl;
+
+		unsigned long long flag_count = 0;
+		for(auto w:flag_word)
+			flag_count += __builtin_popcount(w);
+
+		cout
+			<< "cell count : " << cell_count << '\n'
+			<< "time slot count : " << slot_count << '\n'
+			<< "horizon [ms] : " << horizon << '\n'
+			<< "boundary node count : " << boundary_node_count << '\n'
+			<< "set flags [%] : " << 100.0*flag_count/(static_cast<double>(arc_count)*slot_count*cell_count) << '\n'
+			<< "arc flag memory [byte] : " << flag_word.size()*sizeof(unsigned) << '\n'
+			<< "running time [musec] : " << timer << endl;
+
+		cout << "Saving ... " << flush;
+		save_vector(file_list[8], cell_of_node);
+		save_vector(file_list[9], flag_word);
+		cout << "done" << endl;
+
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+	}
+}
@@ -23,13 +23,15 @@ int main(int argc, char*argv[]){
 		vector<unsigned>first_ipp_of_arc;
 		vector<unsigned>ipp_departure_time;
 		vector<unsigned>ipp_travel_time;
+		vector<unsigned long long>ipp_prefix_integral;
 	
 		string weight_file;
 
-		if(argc != 7){
-			cerr << argv[0] << " window_begin window_end first_ipp_of_arc_file ipp_departure_time_file ipp_travel_time_file weight_file\n"
+		if(argc != 7 && argc != 8){
+			cerr << argv[0] << " window_begin window_end first_ipp_of_arc_file ipp_departure_time_file ipp_travel_time_file weight_file [ipp_prefix_integral_file]\n"
 				<< "Usage: " << argv[0] << " "<<6*60*60*1000<<" "<<10*60*60*1000<<" td/{first_ipp_of_arc,ipp_departure_time,ipp_travel_time} output_weight_file\n"
-				<< "window_begin and window_end are in milliseconds since the begin of the day." << endl;
+				<< "window_begin and window_end are in milliseconds since the begin of the day.\n"
+				<< "If the file computed by compute_ipp_prefix_integral is given, then every weight is computed with two lookups." << endl;
 			return 1;
 		} else {
 			cout << "Loading ... " << flush;
@@ -40,6 +42,8 @@ int main(int argc, char*argv[]){
 			ipp_departure_time = load_vector<unsigned>(argv[4]);
 			ipp_travel_time = load_vector<unsigned>(argv[5]);
 			weight_file = argv[6];
+			if(argc == 8)
+				ipp_prefix_integral = load_vector<unsigned long long>(argv[7]);
 			cout << "done" << endl;
 		}
 
@@ -49,14 +53,24 @@ int main(int argc, char*argv[]){
 		if(period < bucket_end)
 			throw runtime_error("bucket end must be smaller than the period");
 		check_if_arc_ipp_are_valid(period, first_ipp_of_arc, ipp_departure_time, ipp_travel_time);
+		if(argc == 8 && ipp_prefix_integral.size() != ipp_departure_time.size())
+			throw runtime_error("the prefix integral file must have one entry per IPP");
 		cout << "done" << endl;
 
 		cout << "Computing weights ... " << flush;
 
-		vector<unsigned>weight = compute_time_window_avg_weights(
-			bucket_begin, bucket_end,
-			period, first_ipp_of_arc, ipp_departure_time, ipp_travel_time
-		);
+		vector<unsigned>weight;
+		if(argc == 8)
+			weight = compute_time_window_avg_weights_using_prefix(
+				bucket_begin, bucket_end,
+				period, first_ipp_of_arc, ipp_departure_time, ipp_travel_time,
+				ipp_prefix_integral
+			);
+		else
+			weight = compute_time_window_avg_weights(
+				bucket_begin, bucket_end,
+				period, first_ipp_of_arc, ipp_departure_time, ipp_travel_time
+			);
 		cout << "done" << endl;
 
 		cout << "Saving ... " << flush;
@@ -0,0 +1,198 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/inverse_vector.h>
+
+#include "ipp.h"
+#include "verify.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cassert>
+
+using namespace std;
+using namespace RoutingKit;
+
+int main(int argc, char*argv[]){
+	try{
+		const unsigned period = 24*60*60*1000;
+		vector<unsigned>first_out, head, first_ipp_of_arc, ipp_departure_time, ipp_travel_time;
+
+		if(argc != 13){
+			cerr
+				<< "Usage : \n"
+				<< argv[0] << " first_out head first_ipp_of_arc ipp_departure_time ipp_travel_time "
+				<< "out_first_out out_head out_first_ipp_of_arc out_ipp_departure_time out_ipp_travel_time out_first_original_arc_of_arc out_original_arc\n"
+				<< "Example : " << argv[0] << " input/{first_out,head,first_ipp_of_arc,ipp_departure_time,ipp_travel_time} chain/{first_out,head,first_ipp_of_arc,ipp_departure_time,ipp_travel_time,first_original_arc_of_arc,original_arc}" << endl;
+			return 1;
+		}else{
+			cout << "Loading ... " << flush;
+			first_out = load_vector<unsigned>(argv[1]);
+			head = load_vector<unsigned>(argv[2]);
+			first_ipp_of_arc = load_vector<unsigned>(argv[3]);
+			ipp_departure_time = load_vector<unsigned>(argv[4]);
+			ipp_travel_time = load_vector<unsigned>(argv[5]);
+			cout << "done" << endl;
+		}
+
+		cout << "Validity tests ... " << flush;
+		check_if_td_graph_is_valid(period, first_out, head, first_ipp_of_arc, ipp_departure_time, ipp_travel_time);
+		cout << "done" << endl;
+
+		const unsigned node_count = first_out.size()-1;
+		const unsigned arc_count = head.size();
+
+		cout << "Identifying chain nodes ... " << flush;
+		vector<unsigned>tail = invert_inverse_vector(first_out);
+		vector<unsigned>first_in(node_count+1, 0);
+		for(auto x:head)
+			++first_in[x+1];
+		for(unsigned x=0; x<node_count; ++x)
+			first_in[x+1] += first_in[x];
+		vector<unsigned>in_arc(arc_count);
+		{
+			vector<unsigned>next_in = first_in;
+			for(unsigned a=0; a<arc_count; ++a)
+				in_arc[next_in[head[a]]++] = a;
+		}
+
+		// A node is a chain node if it has no route choice, that is either
+		// * it has exactly one incoming arc from u and one outgoing arc to w with u != w, or
+		// * it has arcs in both directions to exactly two neighbors u and w.
+		// Loops and multi-arcs disqualify a node.
+		vector<bool>is_chain_node(node_count, false);
+		unsigned chain_node_count = 0;
+		for(unsigned v=0; v<node_count; ++v){
+			unsigned out_deg = first_out[v+1] - first_out[v];
+			unsigned in_deg = first_in[v+1] - first_in[v];
+			if(out_deg == 1 && in_deg == 1){
+				unsigned w = head[first_out[v]];
+				unsigned u = tail[in_arc[first_in[v]]];
+				is_chain_node[v] = (u != v && w != v && u != w);
+			} else if(out_deg == 2 && in_deg == 2){
+				unsigned w0 = head[first_out[v]], w1 = head[first_out[v]+1];
+				unsigned u0 = tail[in_arc[first_in[v]]], u1 = tail[in_arc[first_in[v]+1]];
+				is_chain_node[v] =
+					w0 != v && w1 != v && w0 != w1 &&
+					((u0 == w0 && u1 == w1) || (u0 == w1 && u1 == w0));
+			}
+			if(is_chain_node[v])
+				++chain_node_count;
+		}
+		cout << "done" << endl;
+
+		cout << "Contracting chains ... " << flush;
+		vector<unsigned>new_tail, new_head;
+		vector<unsigned>new_first_ipp_of_arc = {0}, new_ipp_departure_time, new_ipp_travel_time;
+		vector<unsigned>new_first_original_arc_of_arc = {0}, new_original_arc;
+		vector<bool>is_arc_covered(arc_count, false);
+
+		auto add_chain_starting_with = [&](unsigned a){
+			unsigned chain_tail = tail[a];
+			unsigned prev = tail[a];
+			unsigned v = head[a];
+			vector<IPP>plf;
+			for(unsigned i=first_ipp_of_arc[a]; i<first_ipp_of_arc[a+1]; ++i)
+				plf.push_back({ipp_departure_time[i], ipp_travel_time[i]});
+			new_original_arc.push_back(a);
+			is_arc_covered[a] = true;
+
+			while(is_chain_node[v]){
+				unsigned next = first_out[v];
+				if(first_out[v+1] - first_out[v] == 2 && head[next] == prev)
+					++next;
+				plf = link_plf(make_plf(period, plf), ArcPLF(next, period, first_ipp_of_arc, ipp_departure_time, ipp_travel_time));
+				new_original_arc.push_back(next);
+				is_arc_covered[next] = true;
+				prev = v;
+				v = head[next];
+			}
+
+			new_tail.push_back(chain_tail);
+			new_head.push_back(v);
+			for(auto x:plf){
+				new_ipp_departure_time.push_back(x.departure_time);
+				new_ipp_travel_time.push_back(x.travel_time);
+			}
+			new_first_ipp_of_arc.push_back(new_ipp_departure_time.size());
+			new_first_original_arc_of_arc.push_back(new_original_arc.size());
+		};
+
+		for(unsigned x=0; x<node_count; ++x)
+			if(!is_chain_node[x])
+				for(unsigned a=first_out[x]; a<first_out[x+1]; ++a)
+					add_chain_starting_with(a);
+
+		// Cycles consisting only of chain nodes are not reachable from any other node.
+		// We break them up by keeping one of their nodes.
+		for(unsigned a=0; a<arc_count; ++a){
+			if(!is_arc_covered[a]){
+				unsigned x = tail[a];
+				is_chain_node[x] = false;
+				--chain_node_count;
+				for(unsigned b=first_out[x]; b<first_out[x+1]; ++b)
+					if(!is_arc_covered[b])
+						add_chain_starting_with(b);
+			}
+		}
+		cout << "done" << endl;
+
+		cout << "Sorting arcs ... " << flush;
+		const unsigned new_arc_count = new_head.size();
+		vector<unsigned>new_first_out(node_count+1, 0);
+		for(auto x:new_tail)
+			++new_first_out[x+1];
+		for(unsigned x=0; x<node_count; ++x)
+			new_first_out[x+1] += new_first_out[x];
+
+		vector<unsigned>sorted_arc(new_arc_count);
+		{
+			vector<unsigned>next_out = new_first_out;
+			for(unsigned a=0; a<new_arc_count; ++a)
+				sorted_arc[next_out[new_tail[a]]++] = a;
+		}
+
+		vector<unsigned>out_head(new_arc_count);
+		vector<unsigned>out_first_ipp_of_arc = {0}, out_ipp_departure_time, out_ipp_travel_time;
+		vector<unsigned>out_first_original_arc_of_arc = {0}, out_original_arc;
+		for(unsigned i=0; i<new_arc_count; ++i){
+			unsigned a = sorted_arc[i];
+			out_head[i] = new_head[a];
+			for(unsigned j=new_first_ipp_of_arc[a]; j<new_first_ipp_of_arc[a+1]; ++j){
+				out_ipp_departure_time.push_back(new_ipp_departure_time[j]);
+				out_ipp_travel_time.push_back(new_ipp_travel_time[j]);
+			}
+			out_first_ipp_of_arc.push_back(out_ipp_departure_time.size());
+			for(unsigned j=new_first_original_arc_of_arc[a]; j<new_first_original_arc_of_arc[a+1]; ++j)
+				out_original_arc.push_back(new_original_arc[j]);
+			out_first_original_arc_of_arc.push_back(out_original_arc.size());
+		}
+		cout << "done" << endl;
+
+		cout << "Validity tests ... " << flush;
+		check_if_td_graph_is_valid(period, new_first_out, out_head, out_first_ipp_of_arc, out_ipp_departure_time, out_ipp_travel_time);
+		if(out_original_arc.size() != arc_count)
+			throw runtime_error("not every original arc is part of exactly one chain");
+		cout << "done" << endl;
+
+		cout
+			<< "node count : " << node_count << '\n'
+			<< "contracted chain node count : " << chain_node_count << '\n'
+			<< "arc count : " << arc_count << " -> " << new_arc_count << '\n'
+			<< "ipp count : " << ipp_departure_time.size() << " -> " << out_ipp_departure_time.size() << endl;
+
+		cout << "Saving ... " << flush;
+		save_vector(argv[6], new_first_out);
+		save_vector(argv[7], out_head);
+		save_vector(argv[8], out_first_ipp_of_arc);
+		save_vector(argv[9], out_ipp_departure_time);
+		save_vector(argv[10], out_ipp_travel_time);
+		save_vector(argv[11], out_first_original_arc_of_arc);
+		save_vector(argv[12], out_original_arc);
+		cout << "done" << endl;
+
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+	}
+}
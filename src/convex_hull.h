@@ -0,0 +1,55 @@
+#ifndef CONVEX_HULL_H
+#define CONVEX_HULL_H
+
+#include <vector>
+#include <algorithm>
+
+//! Computes the convex hull of the given nodes using Andrew's monotone chain algorithm.
+//! Longitude is used as x-coordinate and latitude as y-coordinate. Returns the IDs
+//! of the nodes on the hull in counterclockwise order. Collinear nodes are omitted.
+inline
+std::vector<unsigned>compute_convex_hull(std::vector<unsigned>node_list, const std::vector<float>&latitude, const std::vector<float>&longitude){
+	std::sort(node_list.begin(), node_list.end(), [&](unsigned l, unsigned r){
+		if(longitude[l] != longitude[r])
+			return longitude[l] < longitude[r];
+		else
+			return latitude[l] < latitude[r];
+	});
+	node_list.erase(std::unique(node_list.begin(), node_list.end(), [&](unsigned l, unsigned r){
+		return longitude[l] == longitude[r] && latitude[l] == latitude[r];
+	}), node_list.end());
+
+	if(node_list.size() < 3)
+		return node_list;
+
+	auto is_left_turn = [&](unsigned a, unsigned b, unsigned c){
+		double cross =
+			(double(longitude[b]) - longitude[a]) * (double(latitude[c]) - latitude[a]) -
+			(double(latitude[b]) - latitude[a]) * (double(longitude[c]) - longitude[a]);
+		return cross > 0;
+	};
+
+	std::vector<unsigned>hull(2*node_list.size());
+	unsigned hull_size = 0;
+
+	// lower hull
+	for(unsigned i=0; i<node_list.size(); ++i){
+		while(hull_size >= 2 && !is_left_turn(hull[hull_size-2], hull[hull_size-1], node_list[i]))
+			--hull_size;
+		hull[hull_size++] = node_list[i];
+	}
+
+	// upper hull
+	const unsigned lower_hull_size = hull_size + 1;
+	for(unsigned i=node_list.size()-1; i>0; --i){
+		while(hull_size >= lower_hull_size && !is_left_turn(hull[hull_size-2], hull[hull_size-1], node_list[i-1]))
+			--hull_size;
+		hull[hull_size++] = node_list[i-1];
+	}
+
+	// The first node was added a second time at the end.
+	hull.resize(hull_size-1);
+	return hull; // NVRO
+}
+
+#endif
@@ -0,0 +1,208 @@
+#ifndef DEGREE_TWO_CHAINS_H
+#define DEGREE_TWO_CHAINS_H
+
+#include <routingkit/inverse_vector.h>
+
+#include "dijkstra.h"
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <cassert>
+
+//! Answers exact queries on a graph whose degree two chains were contracted by contract_degree_two_chains.
+//! The linked PLF of a contracted arc rounds once while the original arcs round once each, so the two
+//! can differ by a few milliseconds. Contracted arcs are therefore evaluated by evaluating their original
+//! arcs one after another, which yields exactly the times of a search in the original graph. The search
+//! still only visits the nodes of the contracted graph.
+//!
+//! A contracted node has no arcs in the contracted graph. It lies inside one contracted arc per direction
+//! in which its chain can be traversed. A query from such a node first follows these arcs to their heads,
+//! and a query to such a node enters these arcs at their tails.
+class DegreeTwoChains{
+public:
+	//! first_out and head describe the contracted graph. original_head is the head vector of the original graph.
+	DegreeTwoChains(
+		const std::vector<unsigned>&first_out,
+		const std::vector<unsigned>&head,
+		const std::vector<unsigned>&original_head,
+		const std::vector<unsigned>&first_original_arc_of_arc,
+		const std::vector<unsigned>&original_arc
+	):
+		tail(RoutingKit::invert_inverse_vector(first_out)),
+		head(head),
+		first_original_arc_of_arc(first_original_arc_of_arc),
+		original_arc(original_arc){
+
+		const unsigned node_count = first_out.size()-1;
+		const unsigned arc_count = head.size();
+
+		if(first_original_arc_of_arc.size() != arc_count+1 || first_original_arc_of_arc.back() != original_arc.size())
+			throw std::runtime_error("the chain mapping does not match the contracted graph");
+		for(auto a:original_arc)
+			if(a >= original_head.size())
+				throw std::runtime_error("the chain mapping refers to an invalid original arc");
+
+		// The nodes inside a contracted arc are the heads of all but its last original arc.
+		first_position_of_node.assign(node_count+1, 0);
+		for(unsigned a=0; a<arc_count; ++a)
+			for(unsigned i=first_original_arc_of_arc[a]; i+1<first_original_arc_of_arc[a+1]; ++i)
+				++first_position_of_node[original_head[original_arc[i]]+1];
+		for(unsigned x=0; x<node_count; ++x)
+			first_position_of_node[x+1] += first_position_of_node[x];
+
+		position.resize(first_position_of_node.back());
+		std::vector<unsigned>next_position = first_position_of_node;
+		for(unsigned a=0; a<arc_count; ++a)
+			for(unsigned i=first_original_arc_of_arc[a]; i+1<first_original_arc_of_arc[a+1]; ++i)
+				position[next_position[original_head[original_arc[i]]]++] = {a, i};
+	}
+
+	bool is_contracted_node(unsigned x)const{
+		return first_position_of_node[x] != first_position_of_node[x+1];
+	}
+
+	//! Returns the arrival time at the head of the contracted arc when departing at its tail at departure_time.
+	//! get_original_weight(original_arc, departure_time) is the weight function of the original graph.
+	template<class GetOriginalWeightFunc>
+	unsigned get_weight(unsigned arc, unsigned departure_time, const GetOriginalWeightFunc&get_original_weight)const{
+		unsigned arrival_time = follow(first_original_arc_of_arc[arc], first_original_arc_of_arc[arc+1], departure_time, get_original_weight);
+		if(arrival_time == inf_weight)
+			return inf_weight;
+		return arrival_time - departure_time;
+	}
+
+	//! Computes the earliest arrival time at target_node and the corresponding path in terms of original arcs.
+	//! source_node and target_node may be contracted nodes. dij must be a search on the contracted graph.
+	//! Returns inf_weight and an empty path if target_node is unreachable.
+	template<class GetOriginalWeightFunc>
+	unsigned run(
+		Dijkstra&dij,
+		unsigned source_node, unsigned source_time, unsigned target_node,
+		const GetOriginalWeightFunc&get_original_weight,
+		std::vector<unsigned>&original_arc_path
+	)const{
+		original_arc_path.clear();
+		if(source_node == target_node)
+			return source_time;
+
+		auto get_weight = [&](unsigned arc, unsigned departure_time){
+			return this->get_weight(arc, departure_time, get_original_weight);
+		};
+
+		unsigned best_time = inf_weight;
+
+		// If both nodes lie inside the same contracted arc, the target may be reached without leaving the chain.
+		for(unsigned i=first_position_of_node[source_node]; i<first_position_of_node[source_node+1]; ++i){
+			for(unsigned j=first_position_of_node[target_node]; j<first_position_of_node[target_node+1]; ++j){
+				if(position[i].arc == position[j].arc && position[i].original_arc_index < position[j].original_arc_index){
+					unsigned t = follow(position[i].original_arc_index+1, position[j].original_arc_index+1, source_time, get_original_weight);
+					if(t < best_time){
+						best_time = t;
+						original_arc_path.assign(original_arc.begin()+position[i].original_arc_index+1, original_arc.begin()+position[j].original_arc_index+1);
+					}
+				}
+			}
+		}
+
+		// The search starts at the heads of the contracted arcs that contain the source node. The original arcs
+		// original_arc[start_begin[k]], ..., original_arc[start_end[k]-1] lead from the source node to start_node[k].
+		std::vector<unsigned>start_node, start_time, start_begin, start_end;
+		if(!is_contracted_node(source_node)){
+			start_node.push_back(source_node);
+			start_time.push_back(source_time);
+			start_begin.push_back(0);
+			start_end.push_back(0);
+		}else{
+			for(unsigned i=first_position_of_node[source_node]; i<first_position_of_node[source_node+1]; ++i){
+				unsigned a = position[i].arc;
+				unsigned begin = position[i].original_arc_index+1, end = first_original_arc_of_arc[a+1];
+				unsigned t = follow(begin, end, source_time, get_original_weight);
+				if(t == inf_weight)
+					continue;
+				unsigned k = std::find(start_node.begin(), start_node.end(), head[a]) - start_node.begin();
+				if(k == start_node.size()){
+					start_node.push_back(head[a]);
+					start_time.push_back(t);
+					start_begin.push_back(begin);
+					start_end.push_back(end);
+				}else if(t < start_time[k]){
+					start_time[k] = t;
+					start_begin[k] = begin;
+					start_end[k] = end;
+				}
+			}
+		}
+
+		dij.clear();
+		for(unsigned k=0; k<start_node.size(); ++k)
+			dij.add_source_node(start_node[k], start_time[k]);
+
+		// Returns the original arc path from the source node to x, which must be settled.
+		auto get_original_arc_path_to = [&](unsigned x){
+			unsigned k = std::find(start_node.begin(), start_node.end(), dij.path_to(x).front()) - start_node.begin();
+			std::vector<unsigned>path(original_arc.begin()+start_begin[k], original_arc.begin()+start_end[k]);
+			std::vector<unsigned>rest = dij.original_arc_path_to(x, first_original_arc_of_arc, original_arc);
+			path.insert(path.end(), rest.begin(), rest.end());
+			return path; // NVRO
+		};
+
+		if(!is_contracted_node(target_node)){
+			dij.resume(target_node, get_weight);
+			unsigned t = dij.distance_to(target_node);
+			if(t < best_time){
+				best_time = t;
+				original_arc_path = get_original_arc_path_to(target_node);
+			}
+		}else{
+			// The target is reached through the tails of the contracted arcs that contain it.
+			for(unsigned j=first_position_of_node[target_node]; j<first_position_of_node[target_node+1]; ++j){
+				unsigned a = position[j].arc;
+				dij.resume(tail[a], get_weight);
+				unsigned t = dij.distance_to(tail[a]);
+				if(t == inf_weight)
+					continue;
+				t = follow(first_original_arc_of_arc[a], position[j].original_arc_index+1, t, get_original_weight);
+				if(t < best_time){
+					best_time = t;
+					original_arc_path = get_original_arc_path_to(tail[a]);
+					original_arc_path.insert(original_arc_path.end(), original_arc.begin()+first_original_arc_of_arc[a], original_arc.begin()+position[j].original_arc_index+1);
+				}
+			}
+		}
+
+		return best_time;
+	}
+
+private:
+	//! Traverses the original arcs original_arc[begin], ..., original_arc[end-1] starting at departure_time
+	//! and returns the arrival time, or inf_weight if one of the arcs cannot be used.
+	template<class GetOriginalWeightFunc>
+	unsigned follow(unsigned begin, unsigned end, unsigned departure_time, const GetOriginalWeightFunc&get_original_weight)const{
+		unsigned t = departure_time;
+		for(unsigned i=begin; i<end; ++i){
+			unsigned w = get_original_weight(original_arc[i], t);
+			if(w == inf_weight)
+				return inf_weight;
+			t += w;
+		}
+		return t;
+	}
+
+	//! The node original_head[original_arc[original_arc_index]] lies inside the contracted arc.
+	struct ChainPosition{
+		unsigned arc;
+		unsigned original_arc_index;
+	};
+
+	std::vector<unsigned>tail;
+	const std::vector<unsigned>&head;
+	const std::vector<unsigned>&first_original_arc_of_arc;
+	const std::vector<unsigned>&original_arc;
+
+	//! The contracted arcs that contain node x are position[first_position_of_node[x]], ..., position[first_position_of_node[x+1]-1].
+	std::vector<unsigned>first_position_of_node;
+	std::vector<ChainPosition>position;
+};
+
+#endif
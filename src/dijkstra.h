@@ -3,64 +3,93 @@
 
 #include <routingkit/constants.h>
 
-#include "id_queue.h"
-#include "timestamp_flag.h"
+#include "statistics.h"
 
 #include <vector>
+#include <algorithm>
+#include <cassert>
 
 using RoutingKit::invalid_id;
 using RoutingKit::inf_weight;
 
+struct IDKeyPair{
+	unsigned id;
+	unsigned key;
+};
+
+//! The search state of every node is packed into one record of 16 bytes, so that relaxing
+//! an arc touches a single cache line of the head's state. A record is only valid if its stamp
+//! belongs to the current search. Clearing the search therefore only advances a 32-bit counter,
+//! and all records are reset only about every 2^31 searches. The queue is a 4-ary heap
+//! that stores the heap positions in the records and only grows as needed.
 class Dijkstra{
+	static const unsigned tree_arity = 4;
 public:
 	Dijkstra(const std::vector<unsigned>&first_out, const std::vector<unsigned>&head):
-		tentative_distance(first_out.size()-1),
-		predecessor(first_out.size()-1),
-		predecessor_arc(first_out.size()-1),
-		was_popped(first_out.size()-1),
-		queue(first_out.size()-1), 
+		node_state(first_out.size()-1),
+		heap_size(0),
+		queued_stamp(1),
+		current_source_node(invalid_id),
+		current_source_time(0),
 		first_out(first_out), 
 		head(head){}
 
 	void clear(){
-		queue.clear();
-		was_popped.reset_all();
+		heap_size = 0;
+		// Every search uses the two stamps queued_stamp and queued_stamp+1.
+		if(queued_stamp >= max_queued_stamp){
+			for(auto&x:node_state)
+				x.stamp = 0;
+			queued_stamp = 1;
+		}else{
+			queued_stamp += 2;
+		}
+		current_source_node = invalid_id;
 	}
 
 	void add_source_node(unsigned id, unsigned departure_time = 0){
-		tentative_distance[id] = departure_time;
-		predecessor[id] = invalid_id;
-		predecessor_arc[id] = invalid_id;
-		queue.push({id, departure_time});
+		assert(node_state[id].stamp != queued_stamp && node_state[id].stamp != popped_stamp());
+		NodeState&x = node_state[id];
+		x.stamp = queued_stamp;
+		x.predecessor = invalid_id;
+		x.predecessor_arc = invalid_id;
+		heap_push({id, departure_time});
 	}
 
-
 	bool is_finished()const{
-		return queue.empty();
+		return heap_size == 0;
 	}
 
 	template<class GetWeightFunc>
 	IDKeyPair settle(const GetWeightFunc&get_weight){
 		assert(!is_finished());
 
-		auto p = queue.pop();
-		tentative_distance[p.id] = p.key;
-		was_popped.raise(p.id);
+		auto p = heap_pop();
+		TD_S_COUNT(dijkstra_pop_count);
+		node_state[p.id].stamp = popped_stamp();
+		node_state[p.id].queue_pos_or_distance = p.key;
 
 		for(unsigned a=first_out[p.id]; a<first_out[p.id+1]; ++a){
-			if(!was_popped.is_raised(head[a])){
+			NodeState&y = node_state[head[a]];
+			if(y.stamp != popped_stamp()){
+				TD_S_COUNT(dijkstra_relaxed_arc_count);
 				unsigned w = get_weight(a, p.key);
 				if(w < inf_weight){
-					if(queue.contains_id(head[a])){
-						if(queue.decrease_key({head[a], p.key + w})){
-							predecessor[head[a]] = p.id;
-							predecessor_arc[head[a]] = a;
+					if(y.stamp == queued_stamp){
+						if(heap_decrease_key({head[a], p.key + w})){
+							TD_S_COUNT(dijkstra_decrease_key_count);
+							y.predecessor = p.id;
+							y.predecessor_arc = a;
 						}
 					} else {
-						queue.push({head[a], p.key + w});
-						predecessor[head[a]] = p.id;
-						predecessor_arc[head[a]] = a;
+						TD_S_COUNT(dijkstra_push_count);
+						y.stamp = queued_stamp;
+						y.predecessor = p.id;
+						y.predecessor_arc = a;
+						heap_push({head[a], p.key + w});
 					}
+				} else {
+					TD_S_COUNT(dijkstra_pruned_arc_count);
 				}
 			}
 		}
@@ -71,24 +100,101 @@ public:
 	void run(unsigned source_node, unsigned source_time, unsigned target_node, const GetWeightFunc&get_weight){
 		clear();
 		add_source_node(source_node, source_time);
+		current_source_node = source_node;
+		current_source_time = source_time;
+		resume(target_node, get_weight);
+	}
+
+	//! Continues the search of the last run until target_node is settled.
+	//! Returns immediately if target_node was already settled.
+	//! If target_node is invalid_id, then all reachable nodes are settled.
+	//! get_weight must be the same weight function as in the last run.
+	template<class GetWeightFunc>
+	void resume(unsigned target_node, const GetWeightFunc&get_weight){
+		if(target_node != invalid_id && was_popped(target_node))
+			return;
 		while(!is_finished())
 			if(settle(get_weight).id == target_node)
 				return;
 	}
 
+	//! Same as run, but if the last search was started by run or run_or_resume with the same source node
+	//! and source time, then this search is resumed instead of being restarted.
+	//! Returns whether the search was resumed.
+	//! get_weight must be the same weight function as in the last run.
+	template<class GetWeightFunc>
+	bool run_or_resume(unsigned source_node, unsigned source_time, unsigned target_node, const GetWeightFunc&get_weight){
+		if(source_node == current_source_node && source_time == current_source_time){
+			resume(target_node, get_weight);
+			return true;
+		}else{
+			run(source_node, source_time, target_node, get_weight);
+			return false;
+		}
+	}
+
+	//! Same as run, but is_out_of_budget is called with the number of settled nodes after every settled node.
+	//! The search stops if it returns true. Returns false if the search was stopped before target_node was settled.
+	template<class GetWeightFunc, class IsOutOfBudgetFunc>
+	bool run_with_budget(unsigned source_node, unsigned source_time, unsigned target_node, const GetWeightFunc&get_weight, const IsOutOfBudgetFunc&is_out_of_budget){
+		clear();
+		add_source_node(source_node, source_time);
+		current_source_node = source_node;
+		current_source_time = source_time;
+		unsigned settled_node_count = 0;
+		while(!is_finished()){
+			if(settle(get_weight).id == target_node)
+				return true;
+			++settled_node_count;
+			if(is_out_of_budget(settled_node_count))
+				return false;
+		}
+		return true;
+	}
+
+	//! Runs a one-to-many search that stops as soon as all nodes in target_list are settled.
+	//! target_list may contain duplicates. Afterwards distance_to and the path functions
+	//! can be queried for every target.
+	template<class GetWeightFunc>
+	void run_to_all_targets(unsigned source_node, unsigned source_time, const std::vector<unsigned>&target_list, const GetWeightFunc&get_weight){
+		clear();
+		add_source_node(source_node, source_time);
+		unsigned next_unsettled_target = 0;
+		while(!is_finished()){
+			settle(get_weight);
+			// Every target is skipped at most once, making the check amortized constant time per settled node.
+			while(next_unsettled_target < target_list.size() && was_popped(target_list[next_unsettled_target]))
+				++next_unsettled_target;
+			if(next_unsettled_target == target_list.size())
+				return;
+		}
+	}
+
+	//! Settles all nodes that can be reached by end_time and stores them in reached
+	//! together with their arrival times. The nodes are ordered by arrival time.
+	//! The cost only depends on the number of reached nodes and not on the graph size.
+	template<class GetWeightFunc>
+	void run_until(unsigned source_node, unsigned source_time, unsigned end_time, std::vector<IDKeyPair>&reached, const GetWeightFunc&get_weight){
+		clear();
+		reached.clear();
+		add_source_node(source_node, source_time);
+		while(!is_finished() && heap[0].key <= end_time)
+			reached.push_back(settle(get_weight));
+	}
+
 	unsigned distance_to(unsigned x) const {
-		if(was_popped.is_raised(x))
-			return tentative_distance[x];
+		if(was_popped(x))
+			return node_state[x].queue_pos_or_distance;
 		else
 			return inf_weight;
 	}
 
 	std::vector<unsigned>path_to(unsigned x) const {
 		std::vector<unsigned>path;
-		if(was_popped.is_raised(x)){
-			while(predecessor[x] != invalid_id){
+		if(was_popped(x)){
+			while(node_state[x].predecessor != invalid_id){
 				path.push_back(x);
-				x = predecessor[x];
+				x = node_state[x].predecessor;
 			}
 			path.push_back(x);
 			std::reverse(path.begin(), path.end());
@@ -98,23 +204,127 @@ public:
 
 	std::vector<unsigned>arc_path_to(unsigned x) const {
 		std::vector<unsigned>path;
-		if(was_popped.is_raised(x)){
-			while(predecessor[x] != invalid_id){
-				path.push_back(predecessor_arc[x]);
-				x = predecessor[x];
+		if(was_popped(x)){
+			while(node_state[x].predecessor != invalid_id){
+				path.push_back(node_state[x].predecessor_arc);
+				x = node_state[x].predecessor;
 			}
 			std::reverse(path.begin(), path.end());
 		}
 		return path;
 	}
 
+	//! Same as arc_path_to but every arc a is replaced by the arcs
+	//! original_arc[first_original_arc_of_arc[a]], ..., original_arc[first_original_arc_of_arc[a+1]-1].
+	//! This maps paths in a graph with contracted degree two chains back onto the original graph.
+	std::vector<unsigned>original_arc_path_to(unsigned x, const std::vector<unsigned>&first_original_arc_of_arc, const std::vector<unsigned>&original_arc) const {
+		std::vector<unsigned>path;
+		for(auto a:arc_path_to(x))
+			path.insert(path.end(), original_arc.begin()+first_original_arc_of_arc[a], original_arc.begin()+first_original_arc_of_arc[a+1]);
+		return path;
+	}
+
 private:
-	std::vector<unsigned>tentative_distance;
-	std::vector<unsigned>predecessor;
-	std::vector<unsigned>predecessor_arc;
+	//! The experimental prefetching of InterleavedDijkstra reads the queue and the search state.
+	friend class InterleavedDijkstra;
+
+	//! A node is in the queue if its stamp is queued_stamp and was popped if its stamp is
+	//! popped_stamp(). Otherwise it was not reached by the current search and the other members are invalid.
+	//! As a node is never queued and popped at the same time, the heap position and the
+	//! final distance share a member. Until a node is popped its tentative distance is its key in the heap.
+	struct NodeState{
+		unsigned stamp;
+		unsigned queue_pos_or_distance;
+		unsigned predecessor;
+		unsigned predecessor_arc;
+	};
+
+	static const unsigned max_queued_stamp = static_cast<unsigned>(-1) - 2;
+
+	unsigned popped_stamp()const{
+		return queued_stamp + 1;
+	}
+
+	bool was_popped(unsigned x)const{
+		return node_state[x].stamp == popped_stamp();
+	}
+
+	void heap_push(IDKeyPair p){
+		if(heap_size == heap.size())
+			heap.push_back(p);
+		else
+			heap[heap_size] = p;
+		node_state[p.id].queue_pos_or_distance = heap_size;
+		++heap_size;
+		move_up_in_heap(heap_size-1);
+	}
+
+	IDKeyPair heap_pop(){
+		assert(heap_size != 0);
+		IDKeyPair p = heap[0];
+		--heap_size;
+		if(heap_size != 0){
+			heap[0] = heap[heap_size];
+			node_state[heap[0].id].queue_pos_or_distance = 0;
+			move_down_in_heap(0);
+		}
+		return p;
+	}
+
+	//! Returns whether the key was decreased.
+	bool heap_decrease_key(IDKeyPair p){
+		unsigned pos = node_state[p.id].queue_pos_or_distance;
+		assert(pos < heap_size);
+		if(heap[pos].key > p.key){
+			heap[pos].key = p.key;
+			move_up_in_heap(pos);
+			return true;
+		} else {
+			return false;
+		}
+	}
+
+	void move_up_in_heap(unsigned pos){
+		while(pos != 0){
+			unsigned parent = (pos-1)/tree_arity;
+			if(heap[parent].key > heap[pos].key){
+				std::swap(heap[pos], heap[parent]);
+				node_state[heap[pos].id].queue_pos_or_distance = pos;
+				node_state[heap[parent].id].queue_pos_or_distance = parent;
+			}
+			pos = parent;
+		}
+	}
+
+	void move_down_in_heap(unsigned pos){
+		for(;;){
+			unsigned first_child = tree_arity*pos+1;
+			if(first_child >= heap_size)
+				return; // no children
+			unsigned smallest_child = first_child;
+			for(unsigned c = first_child+1; c < std::min(tree_arity*pos+tree_arity+1, heap_size); ++c){
+				if(heap[smallest_child].key > heap[c].key){
+					smallest_child = c;
+				}
+			}
+
+			if(heap[smallest_child].key >= heap[pos].key)
+				return; // no child is smaller
+
+			std::swap(heap[pos], heap[smallest_child]);
+			node_state[heap[pos].id].queue_pos_or_distance = pos;
+			node_state[heap[smallest_child].id].queue_pos_or_distance = smallest_child;
+			pos = smallest_child;
+		}
+	}
+
+	std::vector<NodeState>node_state;
+	std::vector<IDKeyPair>heap;
+	unsigned heap_size;
+	unsigned queued_stamp;
 
-	TimestampFlags was_popped;
-	MinIDQueue queue;
+	unsigned current_source_node;
+	unsigned current_source_time;
 
 	const std::vector<unsigned>&first_out;
 	const std::vector<unsigned>&head;
@@ -0,0 +1,111 @@
+#include <routingkit/vector_io.h>
+
+#include "ipp.h"
+#include "dijkstra.h"
+#include "verify.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cassert>
+#include <random>
+
+using namespace std;
+using namespace RoutingKit;
+
+int main(int argc, char*argv[]){
+	try{
+		const unsigned period = 24*60*60*1000;
+		vector<unsigned>first_out, head, first_ipp_of_arc, ipp_departure_time, ipp_travel_time;
+		unsigned source_count, seed;
+
+		if(argc != 12){
+			cerr
+				<< "Usage : \n"
+				<< argv[0] << " first_out head first_ipp_of_arc ipp_departure_time ipp_travel_time source_count seed output_source output_source_time output_target output_rank\n"
+				<< "Example : " << argv[0] << " input/{first_out,head,first_ipp_of_arc,ipp_departure_time,ipp_travel_time} 1000 42 rank/{source,source_time,target,rank}" << endl;
+			return 1;
+		}else{
+			cout << "Loading ... " << flush;
+			first_out = load_vector<unsigned>(argv[1]);
+			head = load_vector<unsigned>(argv[2]);
+			first_ipp_of_arc = load_vector<unsigned>(argv[3]);
+			ipp_departure_time = load_vector<unsigned>(argv[4]);
+			ipp_travel_time = load_vector<unsigned>(argv[5]);
+			source_count = stoul(argv[6]);
+			seed = stoul(argv[7]);
+			cout << "done" << endl;
+		}
+
+		cout << "Validity tests ... " << flush;
+		check_if_td_graph_is_valid(period, first_out, head, first_ipp_of_arc, ipp_departure_time, ipp_travel_time);
+		cout << "done" << endl;
+
+		const unsigned node_count = first_out.size()-1;
+
+		Dijkstra dij(first_out, head);
+
+		auto get_td_weight = [&](unsigned arc, unsigned departure_time){
+			return evaluate_plf(
+				ArcPLF(
+					arc, period,
+					first_ipp_of_arc, ipp_departure_time, ipp_travel_time
+				),
+				departure_time % period
+			);
+		};
+
+		vector<unsigned>source, source_time, target, rank;
+
+		cout << "Generating queries ... " << flush;
+		// As in generate_synthetic_graph, the numbers are taken from mt19937 directly, because
+		// uniform_int_distribution yields different queries with different standard libraries.
+		mt19937 random_generator(seed);
+		auto random_below = [&](unsigned n){
+			return static_cast<unsigned>((static_cast<unsigned long long>(random_generator()) * n) >> 32);
+		};
+
+		// The target of rank r is the 2^r-th node settled by a time-dependent Dijkstra from the source.
+		for(unsigned i=0; i<source_count; ++i){
+			unsigned s = random_below(node_count);
+			unsigned st = random_below(period);
+
+			dij.clear();
+			dij.add_source_node(s, st);
+			unsigned settled_node_count = 0;
+			unsigned r = 0;
+			while(!dij.is_finished()){
+				unsigned x = dij.settle(get_td_weight).id;
+				++settled_node_count;
+				if(settled_node_count == (1u << r)){
+					if(r != 0){
+						source.push_back(s);
+						source_time.push_back(st);
+						target.push_back(x);
+						rank.push_back(r);
+					}
+					if(r == 31)
+						break;
+					++r;
+				}
+			}
+		}
+		cout << "done" << endl;
+
+		check_if_sst_queries_are_valid(period, node_count, source, source_time, target, rank);
+
+		cout << "query count : " << source.size() << endl;
+
+		cout << "Saving ... " << flush;
+		save_vector(argv[8], source);
+		save_vector(argv[9], source_time);
+		save_vector(argv[10], target);
+		save_vector(argv[11], rank);
+		cout << "done" << endl;
+
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+	}
+}
@@ -0,0 +1,191 @@
+#include <routingkit/vector_io.h>
+
+#include "geo_dist.h"
+#include "verify.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <algorithm>
+
+using namespace std;
+using namespace RoutingKit;
+
+int main(int argc, char*argv[]){
+	try{
+		const unsigned period = 24*60*60*1000;
+		unsigned width, height, highway_spacing, ipp_count, seed;
+		double rush_hour_factor;
+
+		if(argc != 14){
+			cerr
+				<< "Usage : \n"
+				<< argv[0] << " width height highway_spacing ipp_count rush_hour_factor seed output_first_out output_head output_first_ipp_of_arc output_ipp_departure_time output_ipp_travel_time output_latitude output_longitude\n"
+				<< "Example : " << argv[0] << " 1000 1000 20 48 1.5 42 synthetic/{first_out,head,first_ipp_of_arc,ipp_departure_time,ipp_travel_time,latitude,longitude}\n"
+				<< "Generates a perturbed grid of width*height nodes. Every highway_spacing-th row and column is a highway.\n"
+				<< "Every arc gets ipp_count interpolation points. In the peak of the rush hours, the travel time of\n"
+				<< "highways is up to 1+rush_hour_factor times the freeflow travel time." << endl;
+			return 1;
+		}else{
+			width = stoul(argv[1]);
+			height = stoul(argv[2]);
+			highway_spacing = stoul(argv[3]);
+			ipp_count = stoul(argv[4]);
+			rush_hour_factor = stod(argv[5]);
+			seed = stoul(argv[6]);
+		}
+
+		if(width < 2 || height < 2)
+			throw runtime_error("width and height must be at least 2");
+		if(static_cast<unsigned long long>(width)*height >= 0x80000000ull)
+			throw runtime_error("too many nodes");
+		if(highway_spacing == 0)
+			throw runtime_error("highway spacing must not be zero");
+		if(ipp_count == 0 || ipp_count > period)
+			throw runtime_error("ipp count must be between 1 and the period");
+		if(rush_hour_factor < 0)
+			throw runtime_error("rush hour factor must not be negative");
+
+		const unsigned node_count = width*height;
+
+		// The standard distributions are not guaranteed to produce the same numbers with
+		// every standard library. The numbers are therefore derived from mt19937 directly.
+		mt19937 random_generator(seed);
+		auto random_fraction = [&]{
+			return (random_generator() >> 8) * (1.0/16777216.0);
+		};
+
+		cout << "Generating nodes ... " << flush;
+		// Neighboring nodes are about 200m apart.
+		const double coordinate_step = 0.002;
+		vector<float>latitude(node_count), longitude(node_count);
+		for(unsigned y=0; y<height; ++y){
+			for(unsigned x=0; x<width; ++x){
+				unsigned node = y*width + x;
+				latitude[node] = 49.0 + y*coordinate_step + (random_fraction()-0.5)*0.6*coordinate_step;
+				longitude[node] = 8.0 + x*coordinate_step + (random_fraction()-0.5)*0.6*coordinate_step;
+			}
+		}
+		cout << "done" << endl;
+
+		cout << "Generating arcs ... " << flush;
+		const double local_speed = 40.0/3.6; // m/s
+		const double highway_speed = 100.0/3.6; // m/s
+
+		vector<unsigned>first_out(node_count+1, 0);
+		vector<unsigned>head;
+		vector<unsigned>freeflow_travel_time;
+		vector<bool>is_highway;
+
+		auto is_highway_row = [&](unsigned y){ return y % highway_spacing == 0; };
+		auto is_highway_column = [&](unsigned x){ return x % highway_spacing == 0; };
+
+		// Horizontal local roads are removed with some probability to perturb the grid. All vertical
+		// roads and the roads in the first row are kept. This keeps the graph strongly connected.
+		vector<bool>has_horizontal_road(node_count, false);
+		for(unsigned y=0; y<height; ++y)
+			for(unsigned x=0; x+1<width; ++x)
+				has_horizontal_road[y*width+x] = y == 0 || is_highway_row(y) || random_fraction() >= 0.15;
+
+		auto add_arc = [&](unsigned from, unsigned to, bool highway){
+			head.push_back(to);
+			is_highway.push_back(highway);
+			double speed = highway ? highway_speed : local_speed;
+			double length = geo_dist(latitude[from], longitude[from], latitude[to], longitude[to]);
+			freeflow_travel_time.push_back(max(1u, static_cast<unsigned>(1000.0*length/speed)));
+		};
+
+		for(unsigned y=0; y<height; ++y){
+			for(unsigned x=0; x<width; ++x){
+				unsigned node = y*width + x;
+				if(x > 0 && has_horizontal_road[node-1])
+					add_arc(node, node-1, is_highway_row(y));
+				if(x+1 < width && has_horizontal_road[node])
+					add_arc(node, node+1, is_highway_row(y));
+				if(y > 0)
+					add_arc(node, node-width, is_highway_column(x));
+				if(y+1 < height)
+					add_arc(node, node+width, is_highway_column(x));
+				first_out[node+1] = head.size();
+			}
+		}
+		const unsigned arc_count = head.size();
+		cout << "done" << endl;
+
+		if(static_cast<unsigned long long>(arc_count)*ipp_count >= 0x100000000ull)
+			throw runtime_error("too many interpolation points");
+
+		cout << "Generating travel time profiles ... " << flush;
+		const double hour = 60*60*1000;
+		auto rush_hour_shape = [&](double t){
+			auto peak = [&](double center, double width){
+				double d = (t - center) / width;
+				return exp(-0.5*d*d);
+			};
+			return max(peak(8*hour, 1*hour), 0.8*peak(17.5*hour, 1.5*hour));
+		};
+
+		vector<unsigned>first_ipp_of_arc(arc_count+1);
+		vector<unsigned>ipp_departure_time(static_cast<unsigned long long>(arc_count)*ipp_count);
+		vector<unsigned>ipp_travel_time(static_cast<unsigned long long>(arc_count)*ipp_count);
+
+		for(unsigned a=0; a<arc_count; ++a){
+			unsigned begin = a*ipp_count;
+			first_ipp_of_arc[a] = begin;
+
+			// Highways are more congested than local roads. Every arc gets an individual random strength.
+			double strength = rush_hour_factor * (0.5 + 0.5*random_fraction()) * (is_highway[a] ? 1.0 : 0.4);
+			// The phase shift makes the rush hour start at slightly different times on different arcs.
+			double shift = (random_fraction()-0.5) * 0.5 * hour;
+
+			for(unsigned i=0; i<ipp_count; ++i){
+				unsigned departure_time = static_cast<unsigned long long>(i)*period/ipp_count;
+				ipp_departure_time[begin+i] = departure_time;
+				if(ipp_count == 1)
+					ipp_travel_time[begin+i] = freeflow_travel_time[a];
+				else
+					ipp_travel_time[begin+i] = static_cast<unsigned>(freeflow_travel_time[a] * (1.0 + strength*rush_hour_shape(departure_time - shift)));
+			}
+
+			// Enforce the FIFO property: the travel time may not decrease faster than time passes.
+			// Two rounds are needed because the profile wraps around.
+			for(unsigned round=0; round<2; ++round){
+				for(unsigned i=0; i<ipp_count; ++i){
+					unsigned next = i+1 == ipp_count ? 0 : i+1;
+					unsigned gap = next == 0 ? period - ipp_departure_time[begin+i] + ipp_departure_time[begin] : ipp_departure_time[begin+next] - ipp_departure_time[begin+i];
+					if(ipp_travel_time[begin+i] > gap && ipp_travel_time[begin+next] < ipp_travel_time[begin+i] - gap)
+						ipp_travel_time[begin+next] = ipp_travel_time[begin+i] - gap;
+				}
+			}
+		}
+		first_ipp_of_arc[arc_count] = static_cast<unsigned long long>(arc_count)*ipp_count;
+		cout << "done" << endl;
+
+		cout << "Validity tests ... " << flush;
+		check_if_td_graph_is_valid(period, first_out, head, first_ipp_of_arc, ipp_departure_time, ipp_travel_time);
+		cout << "done" << endl;
+
+		cout
+			<< "node count : " << node_count << '\n'
+			<< "arc count : " << arc_count << '\n'
+			<< "ipp count : " << ipp_departure_time.size() << endl;
+
+		cout << "Saving ... " << flush;
+		save_vector(argv[7], first_out);
+		save_vector(argv[8], head);
+		save_vector(argv[9], first_ipp_of_arc);
+		save_vector(argv[10], ipp_departure_time);
+		save_vector(argv[11], ipp_travel_time);
+		save_vector(argv[12], latitude);
+		save_vector(argv[13], longitude);
+		cout << "done" << endl;
+
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+	}
+}
@@ -1,6 +1,8 @@
 #ifndef GEO_DIST_H
 #define GEO_DIST_H
 
+#include <cmath>
+
 inline
 //! Returns the distance in meters.
 double geo_dist(double a_lat, double a_lon, double b_lat, double b_lon){
@@ -0,0 +1,344 @@
+#ifndef GEO_INDEX_H
+#define GEO_INDEX_H
+
+#include <routingkit/constants.h>
+#include <routingkit/inverse_vector.h>
+
+#include "geo_dist.h"
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <cassert>
+
+using RoutingKit::invalid_id;
+
+//! A static spatial index over the nodes and optionally the arcs of a graph.
+//! The coordinates are projected onto a plane using an equirectangular projection
+//! around the center of the bounding box. Nodes and arcs are stored in two uniform
+//! grids, each with a cell size fitted to the density of its elements. The entries of
+//! a grid are packed into one array ordered by cell. The nearest node and arc are
+//! determined using the planar distance, which for road networks is practically equal
+//! to the great-circle distance. The reported distance is computed using geo_dist.
+class GeoIndex{
+public:
+	struct NearestNode{
+		unsigned node;
+		double distance; // in meters
+	};
+
+	struct NearestArc{
+		unsigned arc;
+		double distance; // in meters
+		double fraction; // position of the nearest point on the arc, 0 is the tail and 1 the head
+	};
+
+	GeoIndex(){}
+
+	//! Builds an index over the nodes only.
+	GeoIndex(const std::vector<float>&latitude, const std::vector<float>&longitude){
+		build_projection(latitude, longitude);
+		build_node_grid();
+	}
+
+	//! Builds an index over the nodes and the arcs.
+	GeoIndex(const std::vector<float>&latitude, const std::vector<float>&longitude, const std::vector<unsigned>&first_out, const std::vector<unsigned>&head){
+		if(first_out.size() != latitude.size()+1)
+			throw std::runtime_error("first_out and latitude do not match");
+		build_projection(latitude, longitude);
+		build_node_grid();
+		build_arc_grid(first_out, head);
+	}
+
+	NearestNode find_nearest_node(float lat, float lon)const{
+		assert(!node_entry.empty());
+		double px = project_x(lon), py = project_y(lat);
+
+		unsigned best_node = invalid_id;
+		double best_squared_distance = std::numeric_limits<double>::max();
+
+		node_grid.for_each_cell_by_increasing_distance(px, py, best_squared_distance, [&](unsigned cell){
+			for(unsigned i=first_node_of_cell[cell]; i<first_node_of_cell[cell+1]; ++i){
+				double dx = node_entry[i].x - px, dy = node_entry[i].y - py;
+				double d = dx*dx + dy*dy;
+				if(d < best_squared_distance){
+					best_squared_distance = d;
+					best_node = node_entry[i].id;
+				}
+			}
+		});
+
+		return {best_node, geo_dist(lat, lon, latitude_[best_node], longitude_[best_node])};
+	}
+
+	//! Returns invalid_id as arc if the graph has no arcs or the index was built without arcs.
+	NearestArc find_nearest_arc(float lat, float lon)const{
+		if(arc_entry.empty())
+			return {invalid_id, std::numeric_limits<double>::infinity(), 0};
+
+		double px = project_x(lon), py = project_y(lat);
+
+		unsigned best_arc = invalid_id;
+		double best_fraction = 0;
+		double best_squared_distance = std::numeric_limits<double>::max();
+
+		arc_grid.for_each_cell_by_increasing_distance(px, py, best_squared_distance, [&](unsigned cell){
+			for(unsigned i=first_arc_of_cell[cell]; i<first_arc_of_cell[cell+1]; ++i){
+				const ArcEntry&e = arc_entry[i];
+				double vx = e.head_x - e.tail_x, vy = e.head_y - e.tail_y;
+				double length = vx*vx + vy*vy;
+				double f = 0;
+				if(length > 0)
+					f = std::min(1.0, std::max(0.0, ((px - e.tail_x)*vx + (py - e.tail_y)*vy) / length));
+				double dx = e.tail_x + f*vx - px, dy = e.tail_y + f*vy - py;
+				double d = dx*dx + dy*dy;
+				if(d < best_squared_distance){
+					best_squared_distance = d;
+					best_arc = e.id;
+					best_fraction = f;
+				}
+			}
+		});
+
+		unsigned t = arc_tail[best_arc], h = arc_head[best_arc];
+		double nearest_lat = latitude_[t] + best_fraction*(latitude_[h] - latitude_[t]);
+		double nearest_lon = longitude_[t] + best_fraction*(longitude_[h] - longitude_[t]);
+		return {best_arc, geo_dist(lat, lon, nearest_lat, nearest_lon), best_fraction};
+	}
+
+	unsigned long long memory_usage()const{
+		return
+			sizeof(NodeEntry)*node_entry.size() + sizeof(ArcEntry)*arc_entry.size() +
+			sizeof(unsigned)*(first_node_of_cell.size() + first_arc_of_cell.size() + arc_tail.size() + arc_head.size()) +
+			sizeof(float)*(latitude_.size() + longitude_.size());
+	}
+
+private:
+	struct NodeEntry{
+		double x, y;
+		unsigned id;
+	};
+
+	struct ArcEntry{
+		double tail_x, tail_y, head_x, head_y;
+		unsigned id;
+	};
+
+	struct Grid{
+		double min_x, min_y, cell_size;
+		unsigned cell_count_x, cell_count_y;
+
+		Grid(){}
+
+		//! Covers the given rectangle with about element_count/2 cells.
+		Grid(double min_x, double min_y, double max_x, double max_y, unsigned element_count):
+			min_x(min_x), min_y(min_y){
+			double width = max_x - min_x, height = max_y - min_y;
+			cell_size = std::sqrt(std::max(width*height, 1.0) / std::max(1u, element_count/2));
+			cell_count_x = std::min(65536.0, std::floor(width / cell_size) + 1);
+			cell_count_y = std::min(65536.0, std::floor(height / cell_size) + 1);
+			cell_size = std::max(cell_size, std::max(width / cell_count_x, height / cell_count_y) * (1 + 1e-9));
+		}
+
+		unsigned cell_count()const{
+			return cell_count_x * cell_count_y;
+		}
+
+		unsigned cell_x_of(double x)const{
+			double c = std::floor((x - min_x) / cell_size);
+			return c < 0 ? 0 : c >= cell_count_x ? cell_count_x-1 : static_cast<unsigned>(c);
+		}
+
+		unsigned cell_y_of(double y)const{
+			double c = std::floor((y - min_y) / cell_size);
+			return c < 0 ? 0 : c >= cell_count_y ? cell_count_y-1 : static_cast<unsigned>(c);
+		}
+
+		unsigned cell_of(double x, double y)const{
+			return cell_y_of(y) * cell_count_x + cell_x_of(x);
+		}
+
+		//! Clips the segment against the slightly enlarged cell. The enlargement
+		//! makes sure that rounding never drops a cell that the segment touches.
+		bool does_segment_intersect_cell(double x1, double y1, double x2, double y2, unsigned cell_x, unsigned cell_y)const{
+			const double eps = cell_size * 1e-6;
+			double left = min_x + cell_x*cell_size - eps, right = min_x + (cell_x+1)*cell_size + eps;
+			double bottom = min_y + cell_y*cell_size - eps, top = min_y + (cell_y+1)*cell_size + eps;
+			double t_begin = 0, t_end = 1;
+			auto clip = [&](double p, double q){
+				if(p == 0)
+					return q >= 0;
+				double t = q / p;
+				if(p < 0)
+					t_begin = std::max(t_begin, t);
+				else
+					t_end = std::min(t_end, t);
+				return t_begin <= t_end;
+			};
+			return
+				clip(-(x2-x1), x1-left) && clip(x2-x1, right-x1) &&
+				clip(-(y2-y1), y1-bottom) && clip(y2-y1, top-y1);
+		}
+
+		template<class F>
+		void for_each_cell_of_segment(double x1, double y1, double x2, double y2, const F&f)const{
+			unsigned cx1 = cell_x_of(std::min(x1, x2)), cx2 = cell_x_of(std::max(x1, x2));
+			unsigned cy1 = cell_y_of(std::min(y1, y2)), cy2 = cell_y_of(std::max(y1, y2));
+			for(unsigned y=cy1; y<=cy2; ++y)
+				for(unsigned x=cx1; x<=cx2; ++x)
+					if(does_segment_intersect_cell(x1, y1, x2, y2, x, y))
+						f(y*cell_count_x + x);
+		}
+
+		//! Calls f for the cells in rings of increasing Chebyshev distance around the cell of (px, py)
+		//! until no unvisited cell can contain a point closer than sqrt(best_squared_distance).
+		//! best_squared_distance is updated by f.
+		template<class F>
+		void for_each_cell_by_increasing_distance(double px, double py, const double&best_squared_distance, const F&f)const{
+			const int cx = cell_x_of(px), cy = cell_y_of(py);
+			const int last_x = cell_count_x-1, last_y = cell_count_y-1;
+
+			for(int r=0; ; ++r){
+				int x_begin = std::max(cx-r, 0), x_end = std::min(cx+r, last_x);
+				int y_begin = std::max(cy-r, 0), y_end = std::min(cy+r, last_y);
+				for(int y=y_begin; y<=y_end; ++y){
+					if(y == cy-r || y == cy+r){
+						for(int x=x_begin; x<=x_end; ++x)
+							f(y*cell_count_x + x);
+					}else{
+						if(cx-r >= 0)
+							f(y*cell_count_x + cx-r);
+						if(r != 0 && cx+r <= last_x)
+							f(y*cell_count_x + cx+r);
+					}
+				}
+
+				// Every unvisited cell lies beyond one of the sides of the visited block
+				// that still have cells behind them.
+				double lower_bound = std::numeric_limits<double>::max();
+				if(cx-r > 0)
+					lower_bound = std::min(lower_bound, px - (min_x + (cx-r)*cell_size));
+				if(cx+r < last_x)
+					lower_bound = std::min(lower_bound, (min_x + (cx+r+1)*cell_size) - px);
+				if(cy-r > 0)
+					lower_bound = std::min(lower_bound, py - (min_y + (cy-r)*cell_size));
+				if(cy+r < last_y)
+					lower_bound = std::min(lower_bound, (min_y + (cy+r+1)*cell_size) - py);
+
+				if(lower_bound == std::numeric_limits<double>::max())
+					return;
+				if(lower_bound > 0 && lower_bound*lower_bound >= best_squared_distance)
+					return;
+			}
+		}
+	};
+
+	double project_x(float lon)const{
+		return (lon - center_lon) * meter_per_lon_degree;
+	}
+
+	double project_y(float lat)const{
+		return (lat - center_lat) * meter_per_lat_degree;
+	}
+
+	void build_projection(const std::vector<float>&latitude, const std::vector<float>&longitude){
+		if(latitude.size() != longitude.size())
+			throw std::runtime_error("latitude and longitude must have the same size");
+		if(latitude.empty())
+			throw std::runtime_error("there must be at least one node");
+
+		latitude_ = latitude;
+		longitude_ = longitude;
+
+		float min_lat = *std::min_element(latitude.begin(), latitude.end());
+		float max_lat = *std::max_element(latitude.begin(), latitude.end());
+		float min_lon = *std::min_element(longitude.begin(), longitude.end());
+		float max_lon = *std::max_element(longitude.begin(), longitude.end());
+		center_lat = (min_lat + max_lat) / 2;
+		center_lon = (min_lon + max_lon) / 2;
+
+		const double pi = 3.14159265359;
+		meter_per_lat_degree = 6371000.0 * pi / 180;
+		meter_per_lon_degree = meter_per_lat_degree * std::cos(center_lat * pi / 180);
+
+		min_x = project_x(min_lon);
+		max_x = project_x(max_lon);
+		min_y = project_y(min_lat);
+		max_y = project_y(max_lat);
+	}
+
+	void build_node_grid(){
+		const unsigned node_count = latitude_.size();
+		node_grid = Grid(min_x, min_y, max_x, max_y, node_count);
+		const unsigned cell_count = node_grid.cell_count();
+
+		std::vector<unsigned>cell_of_node(node_count);
+		first_node_of_cell.assign(cell_count+1, 0);
+		for(unsigned i=0; i<node_count; ++i){
+			cell_of_node[i] = node_grid.cell_of(project_x(longitude_[i]), project_y(latitude_[i]));
+			++first_node_of_cell[cell_of_node[i]+1];
+		}
+		for(unsigned c=0; c<cell_count; ++c)
+			first_node_of_cell[c+1] += first_node_of_cell[c];
+
+		node_entry.resize(node_count);
+		std::vector<unsigned>next = first_node_of_cell;
+		for(unsigned i=0; i<node_count; ++i)
+			node_entry[next[cell_of_node[i]]++] = {project_x(longitude_[i]), project_y(latitude_[i]), i};
+	}
+
+	//! Every arc is inserted into all cells that it passes through.
+	void build_arc_grid(const std::vector<unsigned>&first_out, const std::vector<unsigned>&head){
+		arc_tail = RoutingKit::invert_inverse_vector(first_out);
+		arc_head = head;
+
+		const unsigned arc_count = head.size();
+		arc_grid = Grid(min_x, min_y, max_x, max_y, arc_count);
+		const unsigned cell_count = arc_grid.cell_count();
+
+		auto make_entry = [&](unsigned a)->ArcEntry{
+			unsigned t = arc_tail[a], h = arc_head[a];
+			return {project_x(longitude_[t]), project_y(latitude_[t]), project_x(longitude_[h]), project_y(latitude_[h]), a};
+		};
+
+		first_arc_of_cell.assign(cell_count+1, 0);
+		for(unsigned a=0; a<arc_count; ++a){
+			ArcEntry e = make_entry(a);
+			arc_grid.for_each_cell_of_segment(e.tail_x, e.tail_y, e.head_x, e.head_y, [&](unsigned c){ ++first_arc_of_cell[c+1]; });
+		}
+		for(unsigned c=0; c<cell_count; ++c)
+			first_arc_of_cell[c+1] += first_arc_of_cell[c];
+
+		arc_entry.resize(first_arc_of_cell[cell_count]);
+		std::vector<unsigned>next = first_arc_of_cell;
+		for(unsigned a=0; a<arc_count; ++a){
+			ArcEntry e = make_entry(a);
+			arc_grid.for_each_cell_of_segment(e.tail_x, e.tail_y, e.head_x, e.head_y, [&](unsigned c){ arc_entry[next[c]++] = e; });
+		}
+	}
+
+	std::vector<float>latitude_, longitude_;
+	std::vector<unsigned>arc_tail, arc_head;
+
+	float center_lat, center_lon;
+	double meter_per_lat_degree, meter_per_lon_degree;
+	double min_x, min_y, max_x, max_y;
+
+	Grid node_grid;
+	std::vector<unsigned>first_node_of_cell;
+	std::vector<NodeEntry>node_entry;
+
+	Grid arc_grid;
+	std::vector<unsigned>first_arc_of_cell;
+	std::vector<ArcEntry>arc_entry;
+};
+
+//! Returns whether lat and lon are within the valid ranges. NaN is invalid.
+inline
+bool is_valid_coordinate(float lat, float lon){
+	return -90 <= lat && lat <= 90 && -180 <= lon && lon <= 180;
+}
+
+#endif
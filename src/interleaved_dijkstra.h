@@ -0,0 +1,154 @@
+#ifndef INTERLEAVED_DIJKSTRA_H
+#define INTERLEAVED_DIJKSTRA_H
+
+#include "dijkstra.h"
+
+#include <vector>
+#include <algorithm>
+#include <cassert>
+
+struct DijkstraQuery{
+	unsigned source_node;
+	unsigned source_time;
+	unsigned target_node;
+};
+
+//! Answers a sequence of independent point-to-point queries using one Dijkstra search per slot.
+//! Settling a node is a chain of dependent cache misses and a single search therefore mostly
+//! waits for memory. The searches of the slots are advanced round-robin by one settled node
+//! each, and while a search settles a node, the data of the next searches is prefetched in
+//! stages. The cache misses of different queries thereby overlap. At least
+//! prefetch_stage_count+1 slots are needed to hide all stages. With one slot the
+//! queries are answered exactly as by Dijkstra::run without prefetching. The result of every
+//! query does not depend on the slot count.
+//!
+//! This is an experiment. No speedup has been measured so far, as the test graphs fit into
+//! the caches. The prefetching is therefore kept here and not in Dijkstra.
+class InterleavedDijkstra{
+public:
+	//! Number of stages of prefetch_next_settle.
+	static const unsigned prefetch_stage_count = 3;
+
+	InterleavedDijkstra(const std::vector<unsigned>&first_out, const std::vector<unsigned>&head, unsigned slot_count):
+		search_(slot_count, Dijkstra(first_out, head)){
+		assert(slot_count != 0);
+	}
+
+	unsigned slot_count()const{
+		return search_.size();
+	}
+
+	//! The search of a slot. While finish_query is called for a slot, its search contains
+	//! the result of the finished query and distance_to and the path functions can be used.
+	const Dijkstra&search(unsigned slot)const{
+		return search_[slot];
+	}
+
+	//! Answers the queries 0, ..., query_count-1.
+	//!
+	//! start_query(slot, query) must return the DijkstraQuery of query. It is called when
+	//! the query is assigned to the slot and can be used to set up per slot weight data.
+	//! get_weight(slot, arc, departure_time) is the weight function of the query in the slot.
+	//! prefetch_arc(slot, arc, stage) should prefetch the data that get_weight accesses
+	//! for arc as described in prefetch_next_settle. It may do nothing.
+	//! finish_query(slot, query) is called once the target of the query is settled or
+	//! the search ran out of nodes. Afterwards the slot is reused for the next query.
+	//!
+	//! Queries can finish out of order.
+	template<class StartQueryFunc, class GetWeightFunc, class PrefetchArcFunc, class FinishQueryFunc>
+	void run(
+		unsigned query_count,
+		const StartQueryFunc&start_query, const GetWeightFunc&get_weight,
+		const PrefetchArcFunc&prefetch_arc, const FinishQueryFunc&finish_query
+	){
+		const unsigned slot_count = search_.size();
+		std::vector<unsigned>query_of_slot(slot_count, invalid_id), target_of_slot(slot_count);
+		unsigned next_query = 0;
+		unsigned active_slot_count = 0;
+
+		auto start_next_query = [&](unsigned slot){
+			if(next_query == query_count){
+				query_of_slot[slot] = invalid_id;
+				return;
+			}
+			unsigned q = next_query++;
+			DijkstraQuery r = start_query(slot, q);
+			search_[slot].clear();
+			search_[slot].add_source_node(r.source_node, r.source_time);
+			query_of_slot[slot] = q;
+			target_of_slot[slot] = r.target_node;
+			++active_slot_count;
+		};
+
+		for(unsigned s=0; s<slot_count; ++s)
+			start_next_query(s);
+
+		// The slot d positions ahead of the current slot gets the prefetch stage
+		// prefetch_stage_count-d. A slot therefore runs through all stages in order
+		// before it settles its next node.
+		const unsigned stage_count = prefetch_stage_count;
+		const unsigned lookahead = std::min(stage_count, slot_count-1);
+
+		while(active_slot_count != 0){
+			for(unsigned s=0; s<slot_count; ++s){
+				if(query_of_slot[s] == invalid_id)
+					continue;
+
+				for(unsigned d=1; d<=lookahead; ++d){
+					unsigned t = (s+d) % slot_count;
+					if(query_of_slot[t] != invalid_id)
+						prefetch_next_settle(
+							search_[t], stage_count-d,
+							[&](unsigned arc, unsigned stage){prefetch_arc(t, arc, stage);}
+						);
+				}
+
+				Dijkstra&dij = search_[s];
+				bool is_query_finished;
+				if(dij.is_finished())
+					is_query_finished = true;
+				else
+					is_query_finished = dij.settle([&](unsigned arc, unsigned departure_time){return get_weight(s, arc, departure_time);}).id == target_of_slot[s];
+
+				if(is_query_finished){
+					finish_query(s, query_of_slot[s]);
+					--active_slot_count;
+					start_next_query(s);
+				}
+			}
+		}
+	}
+
+private:
+	//! Hints the CPU to load the data that the next settle call of dij accesses. Every stage
+	//! reads the data whose loading was requested by the previous stage. Stage 0 loads the
+	//! adjacency range of the next node, stage 1 its arcs, and stage 2 the search state of the
+	//! arcs' heads. prefetch_arc(arc, stage) is called for every arc in the stages 1 and 2
+	//! so that the caller can prefetch the data of its weight function in two steps.
+	//! The stages only improve the running time if some other work is done between them.
+	template<class PrefetchArcFunc>
+	static void prefetch_next_settle(const Dijkstra&dij, unsigned stage, const PrefetchArcFunc&prefetch_arc){
+		if(dij.is_finished())
+			return;
+		const std::vector<unsigned>&first_out = dij.first_out;
+		const std::vector<unsigned>&head = dij.head;
+		unsigned x = dij.heap[0].id;
+		if(stage == 0){
+			__builtin_prefetch(&first_out[x]);
+		}else if(stage == 1){
+			for(unsigned a=first_out[x]; a<first_out[x+1]; ++a){
+				__builtin_prefetch(&head[a]);
+				prefetch_arc(a, 1);
+			}
+		}else{
+			for(unsigned a=first_out[x]; a<first_out[x+1]; ++a){
+				__builtin_prefetch(&dij.node_state[head[a]]);
+				prefetch_arc(a, 2);
+			}
+		}
+	}
+
+	std::vector<Dijkstra>search_;
+};
+
+#endif
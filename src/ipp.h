@@ -3,6 +3,8 @@
 
 #include <routingkit/min_max.h>
 #include <routingkit/constants.h>
+#include "statistics.h"
+#include <algorithm>
 #include <cassert>
 #include <vector>
 
@@ -106,6 +108,17 @@ LambdaPLF<GetDepartureTime, GetTravelTime> make_plf(unsigned period_, unsigned i
 	return {period_, ipp_count_, std::move(ipp_departure_time_), std::move(ipp_travel_time_)};
 }
 
+//! The returned plf refers to the memory of ipp_list. It must therefore not outlive ipp_list.
+inline
+auto make_plf(unsigned period_, const std::vector<IPP>&ipp_list){
+	const IPP*ipp = ipp_list.data();
+	return make_plf(
+		period_, ipp_list.size(),
+		[ipp](unsigned i){return ipp[i].departure_time;},
+		[ipp](unsigned i){return ipp[i].travel_time;}
+	);
+}
+
 class ArcPLF{
 public:
 	ArcPLF(
@@ -153,6 +166,8 @@ unsigned evaluate_plf(
 	const PLF&plf,
 	unsigned departure_time
 ){
+	TD_S_COUNT(plf_evaluation_count);
+
 	unsigned first_ipp = 0;
 	unsigned last_ipp = plf.ipp_count()-1;
 
@@ -160,9 +175,11 @@ unsigned evaluate_plf(
 		return plf.ipp_travel_time(first_ipp);
 
 	if(departure_time < plf.ipp_departure_time(first_ipp) || plf.ipp_departure_time(last_ipp) <= departure_time){
+		TD_S_COUNT(plf_wrap_around_count);
 		return compute_travel_time_with_wrap_around(plf.period(), get_ipp_of_plf(plf, last_ipp), get_ipp_of_plf(plf, first_ipp), departure_time);
 	} else {
 		while(last_ipp - first_ipp > 1){
+			TD_S_COUNT(plf_binary_search_step_count);
 			unsigned mid = (first_ipp + last_ipp)/2;
 			
 			if(plf.ipp_departure_time(mid) < departure_time) {
@@ -225,6 +242,248 @@ unsigned evaluate_plf_with_stabing(
 	}
 }
 
+//! Inverts the arrival time function of a FIFO plf. Returns for the given arrival time the
+//! duration between the latest departure time d with d + plf(d) <= arrival_time and arrival_time.
+//! d may lie in a previous period. arrival_time must be smaller than the period.
+template<class PLF>
+unsigned evaluate_inverse_plf(
+	const PLF&plf,
+	unsigned arrival_time
+){
+	assert(arrival_time < plf.period());
+
+	const long long period = plf.period();
+	const unsigned ipp_count = plf.ipp_count();
+
+	if(ipp_count == 1)
+		return plf.ipp_travel_time(0);
+
+	auto get_ipp_arrival_time = [&](unsigned i)->long long{
+		return static_cast<long long>(plf.ipp_departure_time(i)) + plf.ipp_travel_time(i);
+	};
+
+	// The IPPs of all periodic copies of the plf are sorted by arrival time because the plf is FIFO.
+	// Determine the copy shift such that the first IPP of the shifted copy is the last first IPP
+	// arriving no later than arrival_time.
+	long long shift = arrival_time - get_ipp_arrival_time(0);
+	if(shift >= 0)
+		shift = shift / period * period;
+	else
+		shift = -((-shift + period - 1) / period * period);
+
+	// Find the last IPP of the shifted copy that arrives no later than arrival_time.
+	unsigned before = 0, after = ipp_count;
+	while(after - before > 1){
+		unsigned mid = (before + after)/2;
+		if(get_ipp_arrival_time(mid) + shift <= arrival_time)
+			before = mid;
+		else
+			after = mid;
+	}
+
+	long long before_departure_time = plf.ipp_departure_time(before) + shift;
+	long long before_travel_time = plf.ipp_travel_time(before);
+	long long after_departure_time, after_travel_time;
+	if(after == ipp_count){
+		after_departure_time = plf.ipp_departure_time(0) + shift + period;
+		after_travel_time = plf.ipp_travel_time(0);
+	}else{
+		after_departure_time = plf.ipp_departure_time(after) + shift;
+		after_travel_time = plf.ipp_travel_time(after);
+	}
+
+	// Evaluates the arrival time in the same way as evaluate_plf does.
+	const long long length = after_departure_time - before_departure_time;
+	auto get_arrival_time = [&](long long departure_time){
+		long long pos = departure_time - before_departure_time;
+		return departure_time + (before_travel_time*(length - pos) + after_travel_time*pos) / length;
+	};
+
+	// Find the latest departure time in the segment. The arrival time is non-decreasing.
+	// The interpolated departure time is nearly always the answer. Otherwise fall back to a binary search.
+	long long before_arrival_time = before_departure_time + before_travel_time;
+	long long after_arrival_time = after_departure_time + after_travel_time;
+	assert(before_arrival_time <= arrival_time && arrival_time < after_arrival_time);
+
+	long long latest_departure_time = before_departure_time + (arrival_time - before_arrival_time) * length / (after_arrival_time - before_arrival_time);
+
+	if(get_arrival_time(latest_departure_time) > arrival_time || get_arrival_time(latest_departure_time+1) <= arrival_time){
+		long long ok = before_departure_time, not_ok = after_departure_time;
+		while(not_ok - ok > 1){
+			long long mid = (ok + not_ok)/2;
+			if(get_arrival_time(mid) <= arrival_time)
+				ok = mid;
+			else
+				not_ok = mid;
+		}
+		latest_departure_time = ok;
+	}
+
+	return arrival_time - latest_departure_time;
+}
+
+//! Removes interpolation points that lie on the line between their neighbors.
+//! ipp_list must be sorted by departure time.
+inline
+void remove_redundant_ipps(std::vector<IPP>&ipp_list){
+	auto is_on_line = [](IPP a, IPP b, IPP c){
+		return
+			static_cast<long long>(b.departure_time - a.departure_time) * (static_cast<long long>(c.travel_time) - static_cast<long long>(a.travel_time)) ==
+			static_cast<long long>(c.departure_time - a.departure_time) * (static_cast<long long>(b.travel_time) - static_cast<long long>(a.travel_time));
+	};
+
+	unsigned out = 0;
+	for(unsigned i=0; i<ipp_list.size(); ++i){
+		while(out >= 2 && is_on_line(ipp_list[out-2], ipp_list[out-1], ipp_list[i]))
+			--out;
+		ipp_list[out++] = ipp_list[i];
+	}
+	ipp_list.resize(out);
+
+	bool is_constant = true;
+	for(auto x:ipp_list)
+		if(x.travel_time != ipp_list.front().travel_time)
+			is_constant = false;
+	if(is_constant && !ipp_list.empty())
+		ipp_list.resize(1);
+}
+
+//! Computes the plf of traversing first an arc with plf f and then an arc with plf g,
+//! i.e., the plf that maps t onto f(t) + g(t+f(t)).
+//! The interpolation points of the result are the interpolation points of f and, for every
+//! interpolation point of g, the last departure time whose rounded arrival at the second arc is
+//! before it and the first departure time whose rounded arrival is not. The travel times at
+//! the interpolation points are exactly what evaluating f and g one after another yields.
+//! In between, the result interpolates linearly while evaluating f and g one after another
+//! rounds down twice. The result can therefore be off by a few milliseconds and the error grows
+//! when linked functions are linked again. DegreeTwoChains evaluates contracted chains exactly.
+template<class FirstPLF, class SecondPLF>
+std::vector<IPP> link_plf(
+	const FirstPLF&f,
+	const SecondPLF&g
+){
+	assert(f.period() == g.period());
+	const unsigned long long period = f.period();
+	const unsigned f_ipp_count = f.ipp_count();
+	const unsigned g_ipp_count = g.ipp_count();
+
+	std::vector<unsigned>departure_time(f_ipp_count);
+	for(unsigned i=0; i<f_ipp_count; ++i)
+		departure_time[i] = f.ipp_departure_time(i);
+
+	// Sweep over the pieces of the arrival function t+f(t) and over the periodically
+	// repeated interpolation points of g. Under FIFO both are sorted.
+	unsigned long long g_day = (f.ipp_departure_time(0) + f.ipp_travel_time(0)) / period;
+	unsigned g_ipp = 0;
+	auto g_arrival_time = [&]{
+		return g_day*period + g.ipp_departure_time(g_ipp);
+	};
+	auto go_to_next_g_ipp = [&]{
+		++g_ipp;
+		if(g_ipp == g_ipp_count){
+			g_ipp = 0;
+			++g_day;
+		}
+	};
+	auto get_arrival_time = [&](unsigned long long t){
+		return t + evaluate_plf(f, t % period);
+	};
+
+	for(unsigned i=0; i<f_ipp_count; ++i){
+		unsigned long long begin_departure = f.ipp_departure_time(i);
+		unsigned long long begin_arrival = begin_departure + f.ipp_travel_time(i);
+		unsigned long long end_departure, end_arrival;
+		if(i+1 == f_ipp_count){
+			end_departure = f.ipp_departure_time(0) + period;
+			end_arrival = end_departure + f.ipp_travel_time(0);
+		} else {
+			end_departure = f.ipp_departure_time(i+1);
+			end_arrival = end_departure + f.ipp_travel_time(i+1);
+		}
+
+		while(g_arrival_time() <= begin_arrival)
+			go_to_next_g_ipp();
+
+		while(g_arrival_time() < end_arrival){
+			unsigned long long x = begin_departure + (g_arrival_time() - begin_arrival)*(end_departure - begin_departure)/(end_arrival - begin_arrival);
+			// The interpolated departure time ignores that evaluate_plf rounds the travel time along f down.
+			// Move it to the first departure time whose rounded arrival reaches the interpolation point of g
+			// and also keep the departure time before it, so that the bend of g lies between two exact points.
+			while(x > begin_departure && get_arrival_time(x-1) >= g_arrival_time())
+				--x;
+			while(x < end_departure && get_arrival_time(x) < g_arrival_time())
+				++x;
+			departure_time.push_back(x % period);
+			if(x > begin_departure)
+				departure_time.push_back((x-1) % period);
+			go_to_next_g_ipp();
+		}
+	}
+
+	std::sort(departure_time.begin(), departure_time.end());
+	departure_time.erase(std::unique(departure_time.begin(), departure_time.end()), departure_time.end());
+
+	std::vector<IPP>result(departure_time.size());
+	for(unsigned i=0; i<departure_time.size(); ++i){
+		unsigned t = departure_time[i];
+		unsigned f_travel_time = evaluate_plf(f, t);
+		result[i] = {t, f_travel_time + evaluate_plf(g, (t + f_travel_time) % period)};
+	}
+	remove_redundant_ipps(result);
+	return result; // NVRO
+}
+
+//! Computes the pointwise minimum of f and g.
+//! The interpolation points of the result are the interpolation points of f and g
+//! at which the respective function is minimal and the intersection points of f and g
+//! rounded down to the next millisecond.
+template<class FirstPLF, class SecondPLF>
+std::vector<IPP> merge_plf(
+	const FirstPLF&f,
+	const SecondPLF&g
+){
+	assert(f.period() == g.period());
+	const unsigned period = f.period();
+
+	// The lowest bit marks whether the departure time is an interpolation point of g.
+	std::vector<unsigned long long>departure_time;
+	for(unsigned i=0; i<f.ipp_count(); ++i)
+		departure_time.push_back(static_cast<unsigned long long>(f.ipp_departure_time(i)) << 1);
+	for(unsigned i=0; i<g.ipp_count(); ++i)
+		departure_time.push_back((static_cast<unsigned long long>(g.ipp_departure_time(i)) << 1) | 1);
+	std::sort(departure_time.begin(), departure_time.end());
+
+	std::vector<IPP>result;
+	for(unsigned i=0; i<departure_time.size(); ++i){
+		unsigned long long begin = departure_time[i] >> 1;
+		bool is_g_ipp = departure_time[i] & 1;
+		unsigned long long end = i+1 == departure_time.size() ? (departure_time[0] >> 1) + period : departure_time[i+1] >> 1;
+
+		long long f_begin = evaluate_plf(f, begin), g_begin = evaluate_plf(g, begin);
+
+		if((!is_g_ipp && f_begin <= g_begin) || (is_g_ipp && g_begin <= f_begin))
+			result.push_back({static_cast<unsigned>(begin), static_cast<unsigned>(std::min(f_begin, g_begin))});
+
+		if(begin == end)
+			continue;
+
+		long long f_end = evaluate_plf(f, end % period), g_end = evaluate_plf(g, end % period);
+		long long diff_begin = f_begin - g_begin, diff_end = f_end - g_end;
+		if((diff_begin < 0 && diff_end > 0) || (diff_begin > 0 && diff_end < 0)){
+			unsigned long long x = begin + static_cast<long long>(end - begin) * diff_begin / (diff_begin - diff_end);
+			if(begin < x && x < end){
+				x %= period;
+				result.push_back({static_cast<unsigned>(x), std::min(evaluate_plf(f, x), evaluate_plf(g, x))});
+			}
+		}
+	}
+
+	std::sort(result.begin(), result.end(), [](IPP l, IPP r){return l.departure_time < r.departure_time;});
+	result.erase(std::unique(result.begin(), result.end()), result.end());
+	remove_redundant_ipps(result);
+	return result; // NVRO
+}
+
 template<class PLF>
 unsigned long long integral_of_plf_without_wraparound_times_two(
 	const PLF&plf,
@@ -294,6 +553,101 @@ unsigned long long integral_of_plf(
 			integral_of_plf_without_wraparound_times_two(plf, 0, end))/2;
 }
 
+//! Returns two times the integral of the piece from (ax, ay) to (bx, by) over [ax, t].
+//! ax may be negative for the piece that wraps around midnight.
+inline
+unsigned long long integral_of_piece_prefix_times_two(long long ax, long long ay, long long bx, long long by, long long t){
+	assert(ax < bx);
+	assert(ax <= t && t <= bx);
+	__int128_t dx = bx-ax;
+	__int128_t dy = by-ay;
+	auto I_times_2dx = [=](__int128_t p){
+		return p*(dy*p + 2*(by*dx-dy*bx));
+	};
+	return (I_times_2dx(t) - I_times_2dx(ax))/dx;
+}
+
+//! Computes for every IPP two times the integral of its arc's plf from 0 to the IPP's departure time.
+//! The result is stored alongside the IPPs, i.e., it has one entry per IPP.
+//! Two times the integral is integral, which avoids rounding within pieces.
+inline
+std::vector<unsigned long long>compute_ipp_prefix_integral_times_two(
+	unsigned period, const std::vector<unsigned>&first_ipp_of_arc, const std::vector<unsigned>&ipp_departure_time, const std::vector<unsigned>&ipp_travel_time
+){
+	const unsigned arc_count = first_ipp_of_arc.size()-1;
+	std::vector<unsigned long long>prefix(ipp_departure_time.size());
+	for(unsigned a=0; a<arc_count; ++a){
+		const unsigned first = first_ipp_of_arc[a], last = first_ipp_of_arc[a+1]-1;
+		// The piece from the last IPP of the previous day to the first IPP covers [0, first departure time].
+		long long wrap_begin = static_cast<long long>(ipp_departure_time[last]) - period;
+		auto wrap_prefix = [&](long long t){
+			return integral_of_piece_prefix_times_two(wrap_begin, ipp_travel_time[last], ipp_departure_time[first], ipp_travel_time[first], t);
+		};
+		prefix[first] = wrap_prefix(ipp_departure_time[first]) - wrap_prefix(0);
+		for(unsigned i=first; i<last; ++i)
+			prefix[i+1] = prefix[i] + static_cast<unsigned long long>(ipp_departure_time[i+1] - ipp_departure_time[i])*(ipp_travel_time[i] + ipp_travel_time[i+1]);
+	}
+	return prefix; // NVRO
+}
+
+//! Returns two times the integral of plf from 0 to t. ipp_prefix_integral_times_two points to the
+//! entry of the plf's first IPP in the array computed by compute_ipp_prefix_integral_times_two.
+//! Costs one binary search over the departure times.
+template<class PLF>
+unsigned long long prefix_integral_of_plf_times_two(
+	const PLF&plf, const unsigned long long*ipp_prefix_integral_times_two,
+	unsigned t
+){
+	const unsigned period = plf.period();
+	const unsigned ipp_count = plf.ipp_count();
+	assert(t <= period);
+
+	if(t < plf.ipp_departure_time(0)){
+		long long wrap_begin = static_cast<long long>(plf.ipp_departure_time(ipp_count-1)) - period;
+		return
+			integral_of_piece_prefix_times_two(wrap_begin, plf.ipp_travel_time(ipp_count-1), plf.ipp_departure_time(0), plf.ipp_travel_time(0), t) -
+			integral_of_piece_prefix_times_two(wrap_begin, plf.ipp_travel_time(ipp_count-1), plf.ipp_departure_time(0), plf.ipp_travel_time(0), 0);
+	}
+
+	// Find the last IPP departing at or before t.
+	unsigned l = 0, r = ipp_count;
+	while(r - l > 1){
+		unsigned m = (l + r) / 2;
+		if(plf.ipp_departure_time(m) <= t)
+			l = m;
+		else
+			r = m;
+	}
+
+	long long bx, by;
+	if(l+1 < ipp_count){
+		bx = plf.ipp_departure_time(l+1);
+		by = plf.ipp_travel_time(l+1);
+	}else{
+		bx = static_cast<long long>(plf.ipp_departure_time(0)) + period;
+		by = plf.ipp_travel_time(0);
+	}
+	return ipp_prefix_integral_times_two[l] + integral_of_piece_prefix_times_two(plf.ipp_departure_time(l), plf.ipp_travel_time(l), bx, by, t);
+}
+
+//! Same as integral_of_plf but uses the prefix integrals. The results can differ by rounding.
+//! If end < begin, then the window wraps around midnight.
+template<class PLF>
+unsigned long long integral_of_plf_using_prefix(
+	const PLF&plf, const unsigned long long*ipp_prefix_integral_times_two,
+	unsigned begin, unsigned end
+){
+	assert(begin <= plf.period());
+	assert(end <= plf.period());
+
+	unsigned long long b = prefix_integral_of_plf_times_two(plf, ipp_prefix_integral_times_two, begin);
+	unsigned long long e = prefix_integral_of_plf_times_two(plf, ipp_prefix_integral_times_two, end);
+	if(begin <= end)
+		return (e - b)/2;
+	else
+		return (prefix_integral_of_plf_times_two(plf, ipp_prefix_integral_times_two, plf.period()) - b + e)/2;
+}
+
 template<class PLF>
 unsigned long long minimum_of_plf(
 	const PLF&plf
@@ -314,6 +668,58 @@ unsigned long long maximum_of_plf(
 	return x;
 }
 
+//! Returns the minimum travel time of all departure times in [begin, end).
+//! If end <= begin, then the window wraps around midnight.
+template<class PLF>
+unsigned minimum_of_plf_in_window(
+	const PLF&plf,
+	unsigned begin, unsigned end
+){
+	const unsigned period = plf.period();
+	assert(begin < period);
+	assert(end <= period);
+
+	auto is_in_window = [&](unsigned t){
+		if(begin < end)
+			return begin <= t && t < end;
+		else
+			return begin <= t || t < end;
+	};
+
+	unsigned x = evaluate_plf(plf, begin);
+	RoutingKit::min_to(x, evaluate_plf(plf, (end + period - 1) % period));
+	for(unsigned i=0; i<plf.ipp_count(); ++i)
+		if(is_in_window(plf.ipp_departure_time(i)))
+			RoutingKit::min_to(x, plf.ipp_travel_time(i));
+	return x;
+}
+
+//! Returns the maximum travel time of all departure times in [begin, end).
+//! If end <= begin, then the window wraps around midnight.
+template<class PLF>
+unsigned maximum_of_plf_in_window(
+	const PLF&plf,
+	unsigned begin, unsigned end
+){
+	const unsigned period = plf.period();
+	assert(begin < period);
+	assert(end <= period);
+
+	auto is_in_window = [&](unsigned t){
+		if(begin < end)
+			return begin <= t && t < end;
+		else
+			return begin <= t || t < end;
+	};
+
+	unsigned x = evaluate_plf(plf, begin);
+	RoutingKit::max_to(x, evaluate_plf(plf, (end + period - 1) % period));
+	for(unsigned i=0; i<plf.ipp_count(); ++i)
+		if(is_in_window(plf.ipp_departure_time(i)))
+			RoutingKit::max_to(x, plf.ipp_travel_time(i));
+	return x;
+}
+
 inline
 std::vector<unsigned>compute_time_window_avg_weights(
 	unsigned window_begin, unsigned window_end,
@@ -334,6 +740,34 @@ std::vector<unsigned>compute_time_window_avg_weights(
 	return weight; // NVRO
 }
 
+//! Same as compute_time_window_avg_weights but uses the prefix integrals computed by
+//! compute_ipp_prefix_integral_times_two. The running time does not depend on the window length.
+inline
+std::vector<unsigned>compute_time_window_avg_weights_using_prefix(
+	unsigned window_begin, unsigned window_end,
+	unsigned period, const std::vector<unsigned>&first_ipp_of_arc, const std::vector<unsigned>&ipp_departure_time, const std::vector<unsigned>&ipp_travel_time,
+	const std::vector<unsigned long long>&ipp_prefix_integral_times_two
+){
+	unsigned arc_count = first_ipp_of_arc.size()-1;
+	assert(window_begin != window_end);
+	assert(ipp_prefix_integral_times_two.size() == ipp_departure_time.size());
+
+	unsigned window_length;
+	if(window_begin < window_end)
+		window_length = window_end - window_begin;
+	else
+		window_length = (period + window_end) - window_begin;
+
+	std::vector<unsigned>weight(arc_count);
+	for(unsigned i=0; i<arc_count; ++i)
+		weight[i] = integral_of_plf_using_prefix(
+			ArcPLF(i, period, first_ipp_of_arc, ipp_departure_time, ipp_travel_time),
+			ipp_prefix_integral_times_two.data() + first_ipp_of_arc[i],
+			window_begin, window_end
+		) / window_length;
+	return weight; // NVRO
+}
+
 inline
 std::vector<unsigned>compute_min_weights(
 	unsigned period, const std::vector<unsigned>&first_ipp_of_arc, const std::vector<unsigned>&ipp_departure_time, const std::vector<unsigned>&ipp_travel_time
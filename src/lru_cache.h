@@ -0,0 +1,109 @@
+#ifndef LRU_CACHE_H
+#define LRU_CACHE_H
+
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <cassert>
+
+//! A bounded key value cache that evicts the least recently used entry.
+//! The cache is split into shards, each protected by its own mutex,
+//! so that threads that access different keys rarely contend.
+template<class Key, class Value, class Hash = std::hash<Key>>
+class ConcurrentLRUCache{
+public:
+	//! The cache holds at most capacity entries in total. As every shard needs room for at least
+	//! one entry, fewer than shard_count shards are used if the capacity is small.
+	explicit ConcurrentLRUCache(unsigned capacity, unsigned shard_count = 16):
+		shard_count(std::max(1u, std::min(shard_count, capacity))), shard(new Shard[this->shard_count]), hit_count_(0), miss_count_(0){
+		assert(shard_count > 0);
+		for(unsigned i=0; i<this->shard_count; ++i)
+			shard[i].capacity = capacity / this->shard_count + (i < capacity % this->shard_count ? 1 : 0);
+	}
+
+	//! Copies the value of key into value and marks the entry as recently used.
+	//! Returns false and leaves value unchanged if key is not in the cache.
+	bool get(const Key&key, Value&value){
+		Shard&s = get_shard(key);
+		std::lock_guard<std::mutex>guard(s.lock);
+		auto iter = s.entry_of_key.find(key);
+		if(iter == s.entry_of_key.end()){
+			++miss_count_;
+			return false;
+		}
+		s.entry_list.splice(s.entry_list.begin(), s.entry_list, iter->second);
+		value = iter->second->second;
+		++hit_count_;
+		return true;
+	}
+
+	//! Inserts or replaces the value of key. Evicts the least recently used entry of the shard if it is full.
+	void put(const Key&key, Value value){
+		Shard&s = get_shard(key);
+		if(s.capacity == 0)
+			return;
+		std::lock_guard<std::mutex>guard(s.lock);
+		auto iter = s.entry_of_key.find(key);
+		if(iter != s.entry_of_key.end()){
+			iter->second->second = std::move(value);
+			s.entry_list.splice(s.entry_list.begin(), s.entry_list, iter->second);
+			return;
+		}
+		if(s.entry_list.size() == s.capacity){
+			s.entry_of_key.erase(s.entry_list.back().first);
+			s.entry_list.pop_back();
+		}
+		s.entry_list.emplace_front(key, std::move(value));
+		s.entry_of_key.emplace(key, s.entry_list.begin());
+	}
+
+	void clear(){
+		for(unsigned i=0; i<shard_count; ++i){
+			std::lock_guard<std::mutex>guard(shard[i].lock);
+			shard[i].entry_list.clear();
+			shard[i].entry_of_key.clear();
+		}
+	}
+
+	unsigned long long size(){
+		unsigned long long n = 0;
+		for(unsigned i=0; i<shard_count; ++i){
+			std::lock_guard<std::mutex>guard(shard[i].lock);
+			n += shard[i].entry_list.size();
+		}
+		return n;
+	}
+
+	unsigned long long hit_count()const{
+		return hit_count_;
+	}
+
+	unsigned long long miss_count()const{
+		return miss_count_;
+	}
+
+private:
+	struct Shard{
+		std::mutex lock;
+		std::list<std::pair<Key, Value>>entry_list;
+		std::unordered_map<Key, typename std::list<std::pair<Key, Value>>::iterator, Hash>entry_of_key;
+		unsigned capacity;
+	};
+
+	Shard&get_shard(const Key&key){
+		// The hash is mixed so that the shard does not correlate with the bucket in the shard's hash map.
+		unsigned long long h = Hash()(key) * 0x9E3779B97F4A7C15ull;
+		return shard[(h >> 32) % shard_count];
+	}
+
+	unsigned shard_count;
+	std::unique_ptr<Shard[]>shard;
+	std::atomic<unsigned long long>hit_count_, miss_count_;
+};
+
+#endif
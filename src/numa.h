@@ -0,0 +1,186 @@
+#ifndef NUMA_H
+#define NUMA_H
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <memory>
+#include <stdexcept>
+#include <algorithm>
+
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+// The NUMA topology is read from sysfs and memory policies are set using the
+// mbind system call, so that no dependency on libnuma is needed. On machines
+// without NUMA support all functions behave as if there was a single node.
+
+#ifndef MADV_COLLAPSE
+#define MADV_COLLAPSE 25
+#endif
+
+const int numa_mpol_interleave = 3;
+const unsigned numa_mpol_mf_move = 1 << 1;
+const unsigned long long huge_page_size = 2 << 20;
+
+//! Parses lists such as "0-3,8,10-11".
+inline
+std::vector<unsigned>parse_numa_id_list(const std::string&list){
+	std::vector<unsigned>id_list;
+	std::stringstream in(list);
+	std::string range;
+	while(std::getline(in, range, ',')){
+		if(range.empty() || range == "\n")
+			continue;
+		auto dash = range.find('-');
+		unsigned first = std::stoul(range.substr(0, dash));
+		unsigned last = dash == std::string::npos ? first : std::stoul(range.substr(dash+1));
+		for(unsigned i=first; i<=last; ++i)
+			id_list.push_back(i);
+	}
+	return id_list; // NVRO
+}
+
+inline
+std::string read_first_line_of_numa_file(const std::string&file_name){
+	std::ifstream in(file_name);
+	std::string line;
+	std::getline(in, line);
+	return line;
+}
+
+inline
+unsigned get_numa_node_count(){
+	std::vector<unsigned>node_list = parse_numa_id_list(read_first_line_of_numa_file("/sys/devices/system/node/online"));
+	if(node_list.empty())
+		return 1;
+	return *std::max_element(node_list.begin(), node_list.end()) + 1;
+}
+
+//! Returns all CPUs if the machine has no NUMA support.
+inline
+std::vector<unsigned>get_cpus_of_numa_node(unsigned node){
+	std::vector<unsigned>cpu_list = parse_numa_id_list(read_first_line_of_numa_file("/sys/devices/system/node/node"+std::to_string(node)+"/cpulist"));
+	if(cpu_list.empty()){
+		unsigned cpu_count = std::max(1u, std::thread::hardware_concurrency());
+		for(unsigned i=0; i<cpu_count; ++i)
+			cpu_list.push_back(i);
+	}
+	return cpu_list; // NVRO
+}
+
+//! Restricts the calling thread to the CPUs of the given node. Memory that the
+//! thread touches first is then by default allocated on this node.
+inline
+void pin_current_thread_to_numa_node(unsigned node){
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for(auto cpu:get_cpus_of_numa_node(node))
+		if(cpu < CPU_SETSIZE)
+			CPU_SET(cpu, &set);
+	if(sched_setaffinity(0, sizeof(set), &set) != 0)
+		throw std::runtime_error("could not pin thread to NUMA node "+std::to_string(node));
+}
+
+//! Returns the range of whole pages inside of [begin, begin+byte_count).
+inline
+std::pair<char*, unsigned long long>get_inner_page_range(const void*begin, unsigned long long byte_count, unsigned long long page_size){
+	unsigned long long b = reinterpret_cast<unsigned long long>(begin);
+	unsigned long long e = b + byte_count;
+	b = (b + page_size - 1) / page_size * page_size;
+	e = e / page_size * page_size;
+	if(e <= b)
+		return {nullptr, 0};
+	return {reinterpret_cast<char*>(b), e - b};
+}
+
+//! Asks the kernel to back the vector with transparent huge pages. Only the 2MB aligned
+//! interior of the vector can be backed. Returns whether the kernel accepted the advice.
+//! The pages are collapsed immediately if the kernel supports it and otherwise in the background.
+template<class T>
+bool advise_huge_pages(const std::vector<T>&v){
+	auto r = get_inner_page_range(v.data(), v.size()*sizeof(T), huge_page_size);
+	if(r.second == 0)
+		return false;
+	if(madvise(r.first, r.second, MADV_HUGEPAGE) != 0)
+		return false;
+	madvise(r.first, r.second, MADV_COLLAPSE);
+	return true;
+}
+
+//! Spreads the pages of the vector round-robin over all NUMA nodes and moves
+//! already allocated pages accordingly. Returns false if the kernel rejected the policy.
+//! With a single node and for vectors without a whole page there is nothing to do.
+template<class T>
+bool interleave_over_numa_nodes(const std::vector<T>&v){
+	const unsigned node_count = get_numa_node_count();
+	if(node_count <= 1)
+		return true;
+	auto r = get_inner_page_range(v.data(), v.size()*sizeof(T), sysconf(_SC_PAGESIZE));
+	if(r.second == 0)
+		return true;
+	std::vector<unsigned long>node_mask((node_count + 8*sizeof(unsigned long) - 1) / (8*sizeof(unsigned long)), 0);
+	for(unsigned i=0; i<node_count; ++i)
+		node_mask[i / (8*sizeof(unsigned long))] |= 1ul << (i % (8*sizeof(unsigned long)));
+	return syscall(SYS_mbind, r.first, r.second, numa_mpol_interleave, node_mask.data(), node_count+1, numa_mpol_mf_move) == 0;
+}
+
+//! Copies x on a thread pinned to the given node. By the first touch policy
+//! the memory of the copy is allocated on this node. The copy must be moved and
+//! not copied afterwards to keep its memory.
+template<class T>
+T copy_on_numa_node(const T&x, unsigned node){
+	std::unique_ptr<T>copy;
+	std::exception_ptr error;
+	std::thread worker([&]{
+		try{
+			pin_current_thread_to_numa_node(node);
+			copy.reset(new T(x));
+		}catch(...){
+			error = std::current_exception();
+		}
+	});
+	worker.join();
+	if(error)
+		std::rethrow_exception(error);
+	return std::move(*copy);
+}
+
+//! Adds the bytes of the vector to byte_count_of_node[n] where n is the node on which the
+//! respective page currently resides. The nodes are queried using move_pages without moving
+//! any page. Pages that were never touched are not counted. byte_count_of_node is enlarged
+//! if needed. Returns false if the kernel cannot report the nodes.
+template<class T>
+bool add_numa_node_residency(const std::vector<T>&v, std::vector<unsigned long long>&byte_count_of_node){
+	if(v.empty())
+		return true;
+	const unsigned long long page_size = sysconf(_SC_PAGESIZE);
+	const unsigned long long begin = reinterpret_cast<unsigned long long>(v.data());
+	const unsigned long long end = begin + v.size()*sizeof(T);
+	std::vector<void*>page;
+	for(unsigned long long p = begin / page_size * page_size; p < end; p += page_size)
+		page.push_back(reinterpret_cast<void*>(p));
+	std::vector<int>status(page.size());
+	if(syscall(SYS_move_pages, 0, page.size(), page.data(), nullptr, status.data(), 0) != 0)
+		return false;
+	for(unsigned i=0; i<page.size(); ++i){
+		if(status[i] < 0)
+			continue;
+		unsigned long long p = reinterpret_cast<unsigned long long>(page[i]);
+		if(byte_count_of_node.size() <= (unsigned)status[i])
+			byte_count_of_node.resize(status[i]+1, 0);
+		byte_count_of_node[status[i]] += std::min(end, p + page_size) - std::max(begin, p);
+	}
+	return true;
+}
+
+template<class T>
+unsigned long long get_vector_memory_usage(const std::vector<T>&v){
+	return v.size()*sizeof(T);
+}
+
+#endif
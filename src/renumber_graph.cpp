@@ -0,0 +1,218 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/inverse_vector.h>
+#include <routingkit/permutation.h>
+
+#include "verify.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cassert>
+
+using namespace std;
+using namespace RoutingKit;
+
+// Returns the nodes in the order in which an undirected breadth-first or depth-first
+// search visits them. Every unvisited node starts a new search in ID order.
+static vector<unsigned>compute_search_order(const vector<unsigned>&first_out, const vector<unsigned>&head, bool is_depth_first){
+	const unsigned node_count = first_out.size()-1;
+	const unsigned arc_count = head.size();
+
+	vector<unsigned>tail = invert_inverse_vector(first_out);
+	vector<unsigned>first_neighbor(node_count+1, 0);
+	for(unsigned a=0; a<arc_count; ++a){
+		++first_neighbor[tail[a]+1];
+		++first_neighbor[head[a]+1];
+	}
+	for(unsigned x=0; x<node_count; ++x)
+		first_neighbor[x+1] += first_neighbor[x];
+	vector<unsigned>neighbor(2*arc_count);
+	{
+		vector<unsigned>next = first_neighbor;
+		for(unsigned a=0; a<arc_count; ++a){
+			neighbor[next[tail[a]]++] = head[a];
+			neighbor[next[head[a]]++] = tail[a];
+		}
+	}
+
+	vector<unsigned>order;
+	order.reserve(node_count);
+	vector<bool>was_visited(node_count, false);
+	vector<unsigned>stack;
+
+	for(unsigned root=0; root<node_count; ++root){
+		if(was_visited[root])
+			continue;
+		if(is_depth_first){
+			stack.push_back(root);
+			while(!stack.empty()){
+				unsigned x = stack.back();
+				stack.pop_back();
+				if(was_visited[x])
+					continue;
+				was_visited[x] = true;
+				order.push_back(x);
+				for(unsigned i=first_neighbor[x+1]; i>first_neighbor[x]; --i)
+					if(!was_visited[neighbor[i-1]])
+						stack.push_back(neighbor[i-1]);
+			}
+		}else{
+			unsigned queue_begin = order.size();
+			was_visited[root] = true;
+			order.push_back(root);
+			while(queue_begin != order.size()){
+				unsigned x = order[queue_begin++];
+				for(unsigned i=first_neighbor[x]; i<first_neighbor[x+1]; ++i){
+					unsigned y = neighbor[i];
+					if(!was_visited[y]){
+						was_visited[y] = true;
+						order.push_back(y);
+					}
+				}
+			}
+		}
+	}
+	return order; // NVRO
+}
+
+int main(int argc, char*argv[]){
+	try{
+		const unsigned period = 24*60*60*1000;
+		vector<unsigned>first_out, head, first_ipp_of_arc, ipp_departure_time, ipp_travel_time;
+		vector<float>latitude, longitude;
+		string order_name;
+
+		if(argc != 20){
+			cerr
+				<< "Usage : \n"
+				<< argv[0] << " first_out head first_ipp_of_arc ipp_departure_time ipp_travel_time latitude longitude bfs|dfs|order_file "
+				<< "out_first_out out_head out_first_ipp_of_arc out_ipp_departure_time out_ipp_travel_time out_latitude out_longitude "
+				<< "out_new_node_of_old_node out_old_node_of_new_node out_new_arc_of_old_arc out_old_arc_of_new_arc\n"
+				<< "Example : " << argv[0] << " input/{first_out,head,first_ipp_of_arc,ipp_departure_time,ipp_travel_time,latitude,longitude} input/cch_order "
+				<< "renumbered/{first_out,head,first_ipp_of_arc,ipp_departure_time,ipp_travel_time,latitude,longitude,new_node_of_old_node,old_node_of_new_node,new_arc_of_old_arc,old_arc_of_new_arc}" << endl;
+			return 1;
+		}else{
+			cout << "Loading ... " << flush;
+			first_out = load_vector<unsigned>(argv[1]);
+			head = load_vector<unsigned>(argv[2]);
+			first_ipp_of_arc = load_vector<unsigned>(argv[3]);
+			ipp_departure_time = load_vector<unsigned>(argv[4]);
+			ipp_travel_time = load_vector<unsigned>(argv[5]);
+			latitude = load_vector<float>(argv[6]);
+			longitude = load_vector<float>(argv[7]);
+			order_name = argv[8];
+			cout << "done" << endl;
+		}
+
+		cout << "Validity tests ... " << flush;
+		check_if_td_graph_is_valid(period, first_out, head, first_ipp_of_arc, ipp_departure_time, ipp_travel_time);
+
+		const unsigned node_count = first_out.size()-1;
+		const unsigned arc_count = head.size();
+
+		if(latitude.size() != node_count || longitude.size() != node_count)
+			throw runtime_error("latitude and longitude must have one entry per node");
+		cout << "done" << endl;
+
+		cout << "Computing node order ... " << flush;
+		// old_node_of_new_node[r] is the node that gets the ID r.
+		vector<unsigned>old_node_of_new_node;
+		if(order_name == "bfs")
+			old_node_of_new_node = compute_search_order(first_out, head, false);
+		else if(order_name == "dfs")
+			old_node_of_new_node = compute_search_order(first_out, head, true);
+		else
+			old_node_of_new_node = load_vector<unsigned>(order_name);
+
+		if(old_node_of_new_node.size() != node_count)
+			throw runtime_error("order has wrong size");
+		if(!is_permutation(old_node_of_new_node))
+			throw runtime_error("order is no permutation");
+
+		vector<unsigned>new_node_of_old_node(node_count);
+		for(unsigned x=0; x<node_count; ++x)
+			new_node_of_old_node[old_node_of_new_node[x]] = x;
+		cout << "done" << endl;
+
+		cout << "Renumbering ... " << flush;
+		// The arcs are sorted by new tail and then by new head, so that a node's
+		// out-arcs are scanned in the order in which their heads are laid out in memory.
+		vector<unsigned>old_arc_of_new_arc;
+		old_arc_of_new_arc.reserve(arc_count);
+		vector<unsigned>new_first_out(node_count+1);
+		new_first_out[0] = 0;
+		for(unsigned x=0; x<node_count; ++x){
+			unsigned old_x = old_node_of_new_node[x];
+			unsigned begin = old_arc_of_new_arc.size();
+			for(unsigned a=first_out[old_x]; a<first_out[old_x+1]; ++a)
+				old_arc_of_new_arc.push_back(a);
+			stable_sort(
+				old_arc_of_new_arc.begin()+begin, old_arc_of_new_arc.end(),
+				[&](unsigned l, unsigned r){ return new_node_of_old_node[head[l]] < new_node_of_old_node[head[r]]; }
+			);
+			new_first_out[x+1] = old_arc_of_new_arc.size();
+		}
+
+		vector<unsigned>new_arc_of_old_arc(arc_count);
+		vector<unsigned>new_head(arc_count);
+		vector<unsigned>new_first_ipp_of_arc(arc_count+1);
+		vector<unsigned>new_ipp_departure_time, new_ipp_travel_time;
+		new_ipp_departure_time.reserve(ipp_departure_time.size());
+		new_ipp_travel_time.reserve(ipp_travel_time.size());
+		new_first_ipp_of_arc[0] = 0;
+		for(unsigned a=0; a<arc_count; ++a){
+			unsigned old_a = old_arc_of_new_arc[a];
+			new_arc_of_old_arc[old_a] = a;
+			new_head[a] = new_node_of_old_node[head[old_a]];
+			for(unsigned i=first_ipp_of_arc[old_a]; i<first_ipp_of_arc[old_a+1]; ++i){
+				new_ipp_departure_time.push_back(ipp_departure_time[i]);
+				new_ipp_travel_time.push_back(ipp_travel_time[i]);
+			}
+			new_first_ipp_of_arc[a+1] = new_ipp_departure_time.size();
+		}
+
+		vector<float>new_latitude(node_count), new_longitude(node_count);
+		for(unsigned x=0; x<node_count; ++x){
+			new_latitude[x] = latitude[old_node_of_new_node[x]];
+			new_longitude[x] = longitude[old_node_of_new_node[x]];
+		}
+		cout << "done" << endl;
+
+		cout << "Validity tests ... " << flush;
+		check_if_td_graph_is_valid(period, new_first_out, new_head, new_first_ipp_of_arc, new_ipp_departure_time, new_ipp_travel_time);
+		cout << "done" << endl;
+
+		auto compute_average_id_gap = [&](const vector<unsigned>&first_out, const vector<unsigned>&head){
+			unsigned long long sum = 0;
+			for(unsigned x=0; x<node_count; ++x)
+				for(unsigned a=first_out[x]; a<first_out[x+1]; ++a)
+					sum += x < head[a] ? head[a] - x : x - head[a];
+			return arc_count == 0 ? 0.0 : static_cast<double>(sum)/arc_count;
+		};
+
+		cout
+			<< "node count : " << node_count << '\n'
+			<< "arc count : " << arc_count << '\n'
+			<< "average |tail-head| ID gap : " << compute_average_id_gap(first_out, head) << " -> " << compute_average_id_gap(new_first_out, new_head) << endl;
+
+		cout << "Saving ... " << flush;
+		save_vector(argv[9], new_first_out);
+		save_vector(argv[10], new_head);
+		save_vector(argv[11], new_first_ipp_of_arc);
+		save_vector(argv[12], new_ipp_departure_time);
+		save_vector(argv[13], new_ipp_travel_time);
+		save_vector(argv[14], new_latitude);
+		save_vector(argv[15], new_longitude);
+		save_vector(argv[16], new_node_of_old_node);
+		save_vector(argv[17], old_node_of_new_node);
+		save_vector(argv[18], new_arc_of_old_arc);
+		save_vector(argv[19], old_arc_of_new_arc);
+		cout << "done" << endl;
+
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+	}
+}
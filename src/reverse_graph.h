@@ -0,0 +1,41 @@
+#ifndef REVERSE_GRAPH_H
+#define REVERSE_GRAPH_H
+
+#include <routingkit/inverse_vector.h>
+
+#include <vector>
+
+//! The graph with all arcs reversed. The arc a of the reverse graph
+//! corresponds to the arc forward_arc[a] of the original graph.
+struct ReverseGraph{
+	std::vector<unsigned>first_out;
+	std::vector<unsigned>head;
+	std::vector<unsigned>forward_arc;
+};
+
+inline
+ReverseGraph compute_reverse_graph(const std::vector<unsigned>&first_out, const std::vector<unsigned>&head){
+	const unsigned node_count = first_out.size()-1;
+	const unsigned arc_count = head.size();
+
+	std::vector<unsigned>tail = RoutingKit::invert_inverse_vector(first_out);
+
+	ReverseGraph g;
+	g.first_out.assign(node_count+1, 0);
+	for(auto x:head)
+		++g.first_out[x+1];
+	for(unsigned x=0; x<node_count; ++x)
+		g.first_out[x+1] += g.first_out[x];
+
+	g.head.resize(arc_count);
+	g.forward_arc.resize(arc_count);
+	std::vector<unsigned>next_out = g.first_out;
+	for(unsigned a=0; a<arc_count; ++a){
+		unsigned back_arc = next_out[head[a]]++;
+		g.head[back_arc] = tail[a];
+		g.forward_arc[back_arc] = a;
+	}
+	return g; // NVRO
+}
+
+#endif
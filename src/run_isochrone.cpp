@@ -0,0 +1,123 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/timer.h>
+
+#include "ipp.h"
+#include "dijkstra.h"
+#include "convex_hull.h"
+#include "verify.h"
+
+#include <iostream>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cassert>
+using namespace std;
+using namespace RoutingKit;
+
+int main(int argc, char*argv[]){
+	try{
+		const unsigned period = 24*60*60*1000;
+		vector<unsigned>first_out, head, first_ipp_of_arc, ipp_departure_time, ipp_travel_time;
+		vector<float>latitude, longitude;
+
+		if(argc != 6 && argc != 8){
+			cerr
+				<< "Usage : \n"
+				<< argv[0] << " first_out head first_ipp_of_arc ipp_departure_time ipp_travel_time [latitude longitude]" << endl;
+			return 1;
+		}else{
+			cerr << "Loading ... " << flush;
+			first_out = load_vector<unsigned>(argv[1]);
+			head = load_vector<unsigned>(argv[2]);
+			first_ipp_of_arc = load_vector<unsigned>(argv[3]);
+			ipp_departure_time = load_vector<unsigned>(argv[4]);
+			ipp_travel_time = load_vector<unsigned>(argv[5]);
+			if(argc == 8){
+				latitude = load_vector<float>(argv[6]);
+				longitude = load_vector<float>(argv[7]);
+			}
+			cerr << "done" << endl;
+		}
+
+		check_if_td_graph_is_valid(period, first_out, head, first_ipp_of_arc, ipp_departure_time, ipp_travel_time);
+
+		const unsigned node_count = first_out.size()-1;
+		const bool has_coordinates = argc == 8;
+
+		if(has_coordinates && (latitude.size() != node_count || longitude.size() != node_count))
+			throw runtime_error("latitude and longitude must have one entry per node");
+
+		Dijkstra dij(first_out, head);
+		vector<IDKeyPair>reached;
+		vector<unsigned>reached_node_list;
+
+		auto get_td_weight = [&](unsigned arc, unsigned departure_time){
+			return evaluate_plf(
+				ArcPLF(
+					arc, period,
+					first_ipp_of_arc, ipp_departure_time, ipp_travel_time
+				),
+				departure_time % period
+			);
+		};
+
+		cout << setprecision(9) << "Ready" << endl;
+
+		for(;;){
+			unsigned source_node, source_time, budget;
+			cin >> source_node >> source_time >> budget;
+
+			if(source_node >= node_count){
+				cout << "source node invalid" << endl;
+				continue;
+			}
+			if(source_time > period){
+				cout << "source time invalid" << endl;
+				continue;
+			}
+			if(budget >= inf_weight - source_time){
+				cout << "budget invalid" << endl;
+				continue;
+			}
+
+			long long isochrone_timer = -get_micro_time();
+			dij.run_until(source_node, source_time, source_time + budget, reached, get_td_weight);
+			isochrone_timer += get_micro_time();
+
+			long long hull_timer = 0;
+			vector<unsigned>hull;
+			if(has_coordinates){
+				hull_timer = -get_micro_time();
+				reached_node_list.resize(reached.size());
+				for(unsigned i=0; i<reached.size(); ++i)
+					reached_node_list[i] = reached[i].id;
+				hull = compute_convex_hull(reached_node_list, latitude, longitude);
+				hull_timer += get_micro_time();
+			}
+
+			cout
+				<< "source node : " << source_node << '\n'
+				<< "source time [ms since midnight] : " << source_time << '\n'
+				<< "budget [ms] : " << budget << '\n'
+				<< "Isochrone running time [musec] : " << isochrone_timer << '\n'
+				<< "reached node count : " << reached.size() << '\n'
+				<< "reached nodes (node arrival time) :";
+			for(auto p:reached)
+				cout << ' ' << p.id << ' ' << p.key;
+			cout << '\n';
+			if(has_coordinates){
+				cout
+					<< "Convex hull running time [musec] : " << hull_timer << '\n'
+					<< "convex hull (latitude longitude) :";
+				for(auto x:hull)
+					cout << ' ' << latitude[x] << ' ' << longitude[x];
+				cout << '\n';
+			}
+			cout << flush;
+		}
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+	}
+}
@@ -0,0 +1,201 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/contraction_hierarchy.h>
+#include <routingkit/timer.h>
+
+#include "ipp.h"
+#include "dijkstra.h"
+#include "verify.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cassert>
+#include <algorithm>
+using namespace std;
+using namespace RoutingKit;
+
+int main(int argc, char*argv[]){
+	try{
+
+		vector<ContractionHierarchy>ch;
+		const unsigned period = 24*60*60*1000;
+		const unsigned sample_step = 10*60*1000;
+		vector<unsigned>first_out, head, first_ipp_of_arc, ipp_departure_time, ipp_travel_time;
+		vector<unsigned>source, source_time, target, rank;
+
+		if(argc <= 10){
+			cerr
+				<< "Usage : \n"
+				<< argv[0] << " first_out head first_ipp_of_arc ipp_departure_time ipp_travel_time source source_time target rank time_window_ch1 [time_window_ch2 [...]]" << endl;
+			return 1;
+		}else{
+			cerr << "Loading ... " << flush;
+			first_out = load_vector<unsigned>(argv[1]);
+			head = load_vector<unsigned>(argv[2]);
+			first_ipp_of_arc = load_vector<unsigned>(argv[3]);
+			ipp_departure_time = load_vector<unsigned>(argv[4]);
+			ipp_travel_time = load_vector<unsigned>(argv[5]);
+			source = load_vector<unsigned>(argv[6]);
+			source_time = load_vector<unsigned>(argv[7]);
+			target = load_vector<unsigned>(argv[8]);
+			rank = load_vector<unsigned>(argv[9]);
+
+			ch.resize(argc-10);
+
+			for(int i=10; i<argc; ++i)
+				ch[i-10] = ContractionHierarchy::load_file(argv[i]);
+			cerr << "done" << endl;
+		}
+
+		check_if_td_graph_is_valid(period, first_out, head, first_ipp_of_arc, ipp_departure_time, ipp_travel_time);
+
+		const unsigned node_count = first_out.size()-1;
+		const unsigned arc_count = head.size();
+		const unsigned time_window_count = ch.size();
+		const unsigned query_count = source.size();
+
+		check_if_sst_queries_are_valid(period, node_count, source, source_time, target, rank);
+
+		for(auto&x:ch)
+			if(x.node_count() != node_count)
+				throw runtime_error("CH has wrong number of nodes");
+
+		ContractionHierarchyQuery ch_query;
+		ch_query.reset(ch[0]);
+
+		vector<bool>is_arc_allowed(arc_count, false);
+		vector<vector<unsigned>>allowed_path_list(time_window_count);
+
+		Dijkstra dij(first_out, head);
+
+		auto get_td_weight = [&](unsigned arc, unsigned departure_time){
+			return evaluate_plf(
+				ArcPLF(
+					arc, period,
+					first_ipp_of_arc, ipp_departure_time, ipp_travel_time
+				),
+				departure_time % period
+			);
+		};
+
+		auto get_pruned_td_weight = [&](unsigned arc, unsigned departure_time){
+			if(is_arc_allowed[arc])
+				return get_td_weight(arc, departure_time);
+			else
+				return inf_weight;
+		};
+
+		auto compute_corridor = [&](unsigned source_node, unsigned target_node){
+			for(auto&p:allowed_path_list)
+				for(auto a:p)
+					is_arc_allowed[a] = false;
+			for(unsigned w=0; w<time_window_count; ++w)
+				allowed_path_list[w] = ch_query.reset(ch[w]).add_source(source_node).add_target(target_node).run().get_arc_path();
+			for(auto&p:allowed_path_list)
+				for(auto a:p)
+					is_arc_allowed[a] = true;
+		};
+
+		// The relative error of a travel time compared to the exact travel time in percent.
+		auto compute_error = [](unsigned long long exact_travel_time, unsigned long long travel_time){
+			if(exact_travel_time == 0)
+				return travel_time == 0 ? 0.0 : 100.0;
+			return 100.0*(static_cast<double>(travel_time) - exact_travel_time)/exact_travel_time;
+		};
+
+		const unsigned rank_count = query_count == 0 ? 0 : *max_element(rank.begin(), rank.end())+1;
+
+		struct RankStatistics{
+			unsigned query_count = 0;
+			unsigned unreachable_count = 0;
+			long long dijkstra_time = 0;
+			long long td_s_time = 0;
+			long long td_s_p_time = 0;
+			double td_s_error_sum = 0;
+			double td_s_max_error = 0;
+			double td_s_p_error_sum = 0;
+			double td_s_p_max_error = 0;
+		};
+		vector<RankStatistics>statistics(rank_count);
+
+		vector<unsigned>profile_target_time(period/sample_step+1);
+
+		for(unsigned i=0; i<query_count; ++i){
+			if(i % 100 == 0)
+				cerr << "Query " << i << " of " << query_count << endl;
+
+			RankStatistics&r = statistics[rank[i]];
+			++r.query_count;
+
+			long long timer = -get_micro_time();
+			dij.run(source[i], source_time[i], target[i], get_td_weight);
+			unsigned exact_target_time = dij.distance_to(target[i]);
+			timer += get_micro_time();
+			r.dijkstra_time += timer;
+
+			if(exact_target_time == inf_weight){
+				++r.unreachable_count;
+				continue;
+			}
+
+			timer = -get_micro_time();
+			compute_corridor(source[i], target[i]);
+			dij.run(source[i], source_time[i], target[i], get_pruned_td_weight);
+			unsigned td_s_target_time = dij.distance_to(target[i]);
+			timer += get_micro_time();
+			r.td_s_time += timer;
+
+			double td_s_error = compute_error(exact_target_time - source_time[i], td_s_target_time - source_time[i]);
+			r.td_s_error_sum += td_s_error;
+			r.td_s_max_error = max(r.td_s_max_error, td_s_error);
+
+			// TD-S+P computes a travel time profile sampled every sample_step. The profile is
+			// linearly interpolated at the query's source time to measure its error.
+			timer = -get_micro_time();
+			compute_corridor(source[i], target[i]);
+			for(unsigned j=0; j<period/sample_step; ++j){
+				dij.run(source[i], j*sample_step, target[i], get_pruned_td_weight);
+				profile_target_time[j] = dij.distance_to(target[i]) - j*sample_step;
+			}
+			profile_target_time[period/sample_step] = profile_target_time[0];
+			timer += get_micro_time();
+			r.td_s_p_time += timer;
+
+			unsigned j = source_time[i] / sample_step;
+			unsigned pos = source_time[i] - j*sample_step;
+			unsigned long long td_s_p_travel_time =
+				(static_cast<unsigned long long>(profile_target_time[j])*(sample_step-pos) + static_cast<unsigned long long>(profile_target_time[j+1])*pos) / sample_step;
+
+			double td_s_p_error = compute_error(exact_target_time - source_time[i], td_s_p_travel_time);
+			r.td_s_p_error_sum += td_s_p_error;
+			r.td_s_p_max_error = max(r.td_s_p_max_error, td_s_p_error);
+		}
+
+		cout << "rank,query_count,unreachable_count,dijkstra_avg_time_musec,td_s_avg_time_musec,td_s_p_avg_time_musec,td_s_avg_error_percent,td_s_max_error_percent,td_s_p_avg_error_percent,td_s_p_max_error_percent\n";
+		for(unsigned k=0; k<rank_count; ++k){
+			const RankStatistics&r = statistics[k];
+			if(r.query_count == 0)
+				continue;
+			unsigned reachable_count = r.query_count - r.unreachable_count;
+			auto avg = [&](double sum, unsigned count){
+				return count == 0 ? 0.0 : sum/count;
+			};
+			cout
+				<< k << ','
+				<< r.query_count << ','
+				<< r.unreachable_count << ','
+				<< avg(r.dijkstra_time, r.query_count) << ','
+				<< avg(r.td_s_time, reachable_count) << ','
+				<< avg(r.td_s_p_time, reachable_count) << ','
+				<< avg(r.td_s_error_sum, reachable_count) << ','
+				<< r.td_s_max_error << ','
+				<< avg(r.td_s_p_error_sum, reachable_count) << ','
+				<< r.td_s_p_max_error << '\n';
+		}
+		cout << flush;
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+	}
+}
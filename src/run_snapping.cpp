@@ -0,0 +1,92 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/timer.h>
+
+#include "geo_index.h"
+
+#include <iostream>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cassert>
+using namespace std;
+using namespace RoutingKit;
+
+static long long get_nano_time(){
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int main(int argc, char*argv[]){
+	try{
+		vector<unsigned>first_out, head;
+		vector<float>latitude, longitude;
+
+		if(argc != 5){
+			cerr
+				<< "Usage : \n"
+				<< argv[0] << " first_out head latitude longitude" << endl;
+			return 1;
+		}else{
+			cerr << "Loading ... " << flush;
+			first_out = load_vector<unsigned>(argv[1]);
+			head = load_vector<unsigned>(argv[2]);
+			latitude = load_vector<float>(argv[3]);
+			longitude = load_vector<float>(argv[4]);
+			cerr << "done" << endl;
+		}
+
+		const unsigned node_count = first_out.size()-1;
+
+		if(latitude.size() != node_count || longitude.size() != node_count)
+			throw runtime_error("latitude and longitude must have one entry per node");
+
+		cerr << "Building index ... " << flush;
+		long long build_timer = -get_micro_time();
+		GeoIndex index(latitude, longitude, first_out, head);
+		build_timer += get_micro_time();
+		cerr << "done" << endl;
+		cerr
+			<< "index build running time [musec] : " << build_timer << '\n'
+			<< "index memory [byte] : " << index.memory_usage() << endl;
+
+		cout << setprecision(9) << "Ready" << endl;
+
+		for(;;){
+			float lat, lon;
+			cin >> lat >> lon;
+
+			if(!is_valid_coordinate(lat, lon)){
+				cout << "coordinate invalid" << endl;
+				continue;
+			}
+
+			long long node_timer = -get_nano_time();
+			GeoIndex::NearestNode nearest_node = index.find_nearest_node(lat, lon);
+			node_timer += get_nano_time();
+
+			long long arc_timer = -get_nano_time();
+			GeoIndex::NearestArc nearest_arc = index.find_nearest_arc(lat, lon);
+			arc_timer += get_nano_time();
+
+			cout
+				<< "latitude longitude : " << lat << ' ' << lon << '\n'
+				<< "Nearest node running time [nsec] : " << node_timer << '\n'
+				<< "nearest node : " << nearest_node.node << '\n'
+				<< "nearest node distance [m] : " << nearest_node.distance << '\n'
+				<< "Nearest arc running time [nsec] : " << arc_timer << '\n';
+			if(nearest_arc.arc == invalid_id){
+				cout << "nearest arc : none" << '\n';
+			}else{
+				cout
+					<< "nearest arc : " << nearest_arc.arc << '\n'
+					<< "nearest arc distance [m] : " << nearest_arc.distance << '\n'
+					<< "nearest arc position [fraction from tail] : " << nearest_arc.fraction << '\n';
+			}
+			cout << flush;
+		}
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+	}
+}
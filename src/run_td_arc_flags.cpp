@@ -0,0 +1,133 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/timer.h>
+
+#include "ipp.h"
+#include "dijkstra.h"
+#include "arc_flags.h"
+#include "verify.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cassert>
+using namespace std;
+using namespace RoutingKit;
+
+int main(int argc, char*argv[]){
+	try{
+		const unsigned period = 24*60*60*1000;
+		vector<unsigned>first_out, head, first_ipp_of_arc, ipp_departure_time, ipp_travel_time;
+
+		vector<unsigned>cell_of_node, arc_flag_word;
+
+		if(argc != 8){
+			cerr
+				<< "Usage : \n"
+				<< argv[0] << " first_out head first_ipp_of_arc ipp_departure_time ipp_travel_time cell arc_flags" << endl;
+			return 1;
+		}else{
+			cerr << "Loading ... " << flush;
+			first_out = load_vector<unsigned>(argv[1]);
+			head = load_vector<unsigned>(argv[2]);
+			first_ipp_of_arc = load_vector<unsigned>(argv[3]);
+			ipp_departure_time = load_vector<unsigned>(argv[4]);
+			ipp_travel_time = load_vector<unsigned>(argv[5]);
+			cell_of_node = load_vector<unsigned>(argv[6]);
+			arc_flag_word = load_vector<unsigned>(argv[7]);
+			cerr << "done" << endl;
+		}
+
+		check_if_td_graph_is_valid(period, first_out, head, first_ipp_of_arc, ipp_departure_time, ipp_travel_time);
+
+		const unsigned node_count = first_out.size()-1;
+		const unsigned arc_count = head.size();
+
+		if(cell_of_node.size() != node_count)
+			throw runtime_error("cell vector has wrong size");
+
+		TimeDependentArcFlags arc_flags(period, arc_count, move(cell_of_node), move(arc_flag_word));
+
+		Dijkstra dij(first_out, head);
+
+		auto get_td_weight = [&](unsigned arc, unsigned departure_time){
+			return evaluate_plf(
+				ArcPLF(
+					arc, period,
+					first_ipp_of_arc, ipp_departure_time, ipp_travel_time
+				),
+				departure_time % period
+			);
+		};
+
+		unsigned target_cell = 0;
+
+		auto get_flagged_td_weight = [&](unsigned arc, unsigned departure_time){
+			if(arc_flags.is_arc_flagged(arc, departure_time % period, target_cell))
+				return get_td_weight(arc, departure_time);
+			else
+				return inf_weight;
+		};
+
+		cout << "Ready" << endl;
+
+		for(;;){
+			unsigned source_node, source_time, target_node;
+			cin >> source_node >> source_time >> target_node;
+
+			if(source_node > node_count){
+				cout << "source node invalid" << endl;
+				continue;
+			}
+			if(target_node > node_count){
+				cout << "target node invalid" << endl;
+				continue;
+			}
+			if(source_time > period){
+				cout << "source time invalid" << endl;
+				continue;
+			}
+
+			long long baseline_timer = -get_micro_time();
+			dij.run(source_node, source_time, target_node, get_td_weight);
+			unsigned exact_target_time = dij.distance_to(target_node);
+			vector<unsigned>exact_path = dij.arc_path_to(target_node);
+			baseline_timer += get_micro_time();
+
+			long long td_af_timer = -get_micro_time();
+			target_cell = arc_flags.cell_of_node(target_node);
+			dij.run(source_node, source_time, target_node, get_flagged_td_weight);
+			unsigned td_af_target_time = dij.distance_to(target_node);
+			vector<unsigned>td_af_path = dij.arc_path_to(target_node);
+			td_af_timer += get_micro_time();
+
+			cout
+				<< "source node : " << source_node << '\n'
+				<< "source time [ms since midnight] : " << source_time << '\n'
+				<< "target node : " << target_node << '\n'
+				<< "Dijkstra running time [musec] : " << baseline_timer << '\n'
+				<< "TD-AF query running time [musec] : " << td_af_timer  << '\n';
+			if(exact_target_time == inf_weight){
+				cout << "No path" << endl;
+			} else {
+				cout
+					<< "Exact target time [ms since midnight] : " << exact_target_time << '\n'
+					<< "Exact travel time [ms since midnight] : " << (exact_target_time-source_time) << '\n'
+					<< "Exact arc path :";
+				for(auto a:exact_path)
+					cout << ' ' << a;
+				cout << endl;
+				cout
+					<< "TD-AF target time [ms since midnight] : " << td_af_target_time << '\n'
+					<< "TD-AF travel time [ms since midnight] : " << (td_af_target_time-source_time) << '\n'
+					<< "TD-AF arc path :";
+				for(auto a:td_af_path)
+					cout << ' ' << a;
+				cout << endl;
+			}
+		}
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+	}
+}
@@ -0,0 +1,146 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/permutation.h>
+#include <routingkit/timer.h>
+
+#include "ipp.h"
+#include "dijkstra.h"
+#include "td_cch.h"
+#include "verify.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cassert>
+using namespace std;
+using namespace RoutingKit;
+
+int main(int argc, char*argv[]){
+	try{
+		const unsigned period = 24*60*60*1000;
+		vector<unsigned>first_out, head, first_ipp_of_arc, ipp_departure_time, ipp_travel_time;
+
+		vector<unsigned>cch_order;
+
+		if(argc != 7){
+			cerr
+				<< "Usage : \n"
+				<< argv[0] << " first_out head first_ipp_of_arc ipp_departure_time ipp_travel_time cch_order" << endl;
+			return 1;
+		}else{
+			cerr << "Loading ... " << flush;
+			first_out = load_vector<unsigned>(argv[1]);
+			head = load_vector<unsigned>(argv[2]);
+			first_ipp_of_arc = load_vector<unsigned>(argv[3]);
+			ipp_departure_time = load_vector<unsigned>(argv[4]);
+			ipp_travel_time = load_vector<unsigned>(argv[5]);
+			cch_order = load_vector<unsigned>(argv[6]);
+			cerr << "done" << endl;
+		}
+
+		check_if_td_graph_is_valid(period, first_out, head, first_ipp_of_arc, ipp_departure_time, ipp_travel_time);
+
+		const unsigned node_count = first_out.size()-1;
+
+		if(cch_order.size() != node_count)
+			throw runtime_error("CCH order has wrong size");
+
+		if(!is_permutation(cch_order))
+			throw runtime_error("CCH order is no permutation");
+
+		cerr << "Customizing TD-CCH ... " << flush;
+		long long customization_timer = -get_micro_time();
+		TimeDependentCCH td_cch(period, cch_order, first_out, head, first_ipp_of_arc, ipp_departure_time, ipp_travel_time);
+		customization_timer += get_micro_time();
+		cerr << "done" << endl;
+
+		cout
+			<< "TD-CCH customization time [musec] : " << customization_timer << '\n'
+			<< "TD-CCH arc count : " << td_cch.cch_arc_count() << '\n'
+			<< "TD-CCH ipp count : " << td_cch.ipp_count() << '\n'
+			<< "TD-CCH memory [byte] : " << td_cch.memory_usage() << endl;
+
+		TimeDependentCCHQuery td_cch_query(td_cch);
+
+		Dijkstra dij(first_out, head);
+
+		auto get_td_weight = [&](unsigned arc, unsigned departure_time){
+			return evaluate_plf(
+				ArcPLF(
+					arc, period,
+					first_ipp_of_arc, ipp_departure_time, ipp_travel_time
+				),
+				departure_time % period
+			);
+		};
+
+		auto compute_target_time_along_path = [&](unsigned source_time, const vector<unsigned>&path){
+			unsigned target_time = source_time;
+			for(auto arc:path)
+				target_time += get_td_weight(arc, target_time);
+			return target_time;
+		};
+
+		cout << "Ready" << endl;
+
+		for(;;){
+			unsigned source_node, source_time, target_node;
+			cin >> source_node >> source_time >> target_node;
+
+			if(source_node > node_count){
+				cout << "source node invalid" << endl;
+				continue;
+			}
+			if(target_node > node_count){
+				cout << "target node invalid" << endl;
+				continue;
+			}
+			if(source_time > period){
+				cout << "source time invalid" << endl;
+				continue;
+			}
+
+			long long baseline_timer = -get_micro_time();
+			dij.run(source_node, source_time, target_node, get_td_weight);
+			unsigned exact_target_time = dij.distance_to(target_node);
+			vector<unsigned>exact_path = dij.arc_path_to(target_node);
+			baseline_timer += get_micro_time();
+
+			long long td_cch_timer = -get_micro_time();
+			td_cch_query.run(source_node, source_time, target_node);
+			vector<unsigned>td_cch_path = td_cch_query.get_arc_path();
+			td_cch_timer += get_micro_time();
+
+			// The arrival time is evaluated along the unpacked path so that it is consistent with the arc weights.
+			unsigned td_cch_target_time = td_cch_path.empty() && source_node != target_node ? inf_weight : compute_target_time_along_path(source_time, td_cch_path);
+
+			cout
+				<< "source node : " << source_node << '\n'
+				<< "source time [ms since midnight] : " << source_time << '\n'
+				<< "target node : " << target_node << '\n'
+				<< "Dijkstra running time [musec] : " << baseline_timer << '\n'
+				<< "TD-CCH query running time [musec] : " << td_cch_timer  << '\n';
+			if(exact_target_time == inf_weight){
+				cout << "No path" << endl;
+			} else {
+				cout
+					<< "Exact target time [ms since midnight] : " << exact_target_time << '\n'
+					<< "Exact travel time [ms since midnight] : " << (exact_target_time-source_time) << '\n'
+					<< "Exact arc path :";
+				for(auto a:exact_path)
+					cout << ' ' << a;
+				cout << endl;
+				cout
+					<< "TD-CCH target time [ms since midnight] : " << td_cch_target_time << '\n'
+					<< "TD-CCH travel time [ms since midnight] : " << (td_cch_target_time-source_time) << '\n'
+					<< "TD-CCH arc path :";
+				for(auto a:td_cch_path)
+					cout << ' ' << a;
+				cout << endl;
+			}
+		}
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+	}
+}
@@ -0,0 +1,125 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/timer.h>
+
+#include "ipp.h"
+#include "dijkstra.h"
+#include "degree_two_chains.h"
+#include "verify.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cassert>
+#include <memory>
+using namespace std;
+using namespace RoutingKit;
+
+int main(int argc, char*argv[]){
+	try{
+		const unsigned period = 24*60*60*1000;
+		vector<unsigned>first_out, head, first_ipp_of_arc, ipp_departure_time, ipp_travel_time;
+		vector<unsigned>chain_first_out, chain_head, first_original_arc_of_arc, original_arc;
+
+		if(argc != 6 && argc != 10){
+			cerr
+				<< "Usage : \n"
+				<< argv[0] << " first_out head first_ipp_of_arc ipp_departure_time ipp_travel_time [chain_first_out chain_head first_original_arc_of_arc original_arc]\n"
+				<< "If the output of contract_degree_two_chains is given, then the search runs on the contracted graph." << endl;
+			return 1;
+		}else{
+			cerr << "Loading ... " << flush;
+			first_out = load_vector<unsigned>(argv[1]);
+			head = load_vector<unsigned>(argv[2]);
+			first_ipp_of_arc = load_vector<unsigned>(argv[3]);
+			ipp_departure_time = load_vector<unsigned>(argv[4]);
+			ipp_travel_time = load_vector<unsigned>(argv[5]);
+			if(argc == 10){
+				chain_first_out = load_vector<unsigned>(argv[6]);
+				chain_head = load_vector<unsigned>(argv[7]);
+				first_original_arc_of_arc = load_vector<unsigned>(argv[8]);
+				original_arc = load_vector<unsigned>(argv[9]);
+			}
+			cerr << "done" << endl;
+		}
+
+		check_if_td_graph_is_valid(period, first_out, head, first_ipp_of_arc, ipp_departure_time, ipp_travel_time);
+
+		const unsigned node_count = first_out.size()-1;
+		const bool is_contracted = argc == 10;
+
+		if(is_contracted && chain_first_out.size() != first_out.size())
+			throw runtime_error("the contracted graph has a different number of nodes");
+
+		Dijkstra dij(is_contracted ? chain_first_out : first_out, is_contracted ? chain_head : head);
+		unique_ptr<DegreeTwoChains>chains;
+		if(is_contracted)
+			chains.reset(new DegreeTwoChains(chain_first_out, chain_head, head, first_original_arc_of_arc, original_arc));
+
+		auto get_td_weight = [&](unsigned arc, unsigned departure_time){
+			return evaluate_plf(
+				ArcPLF(
+					arc, period,
+					first_ipp_of_arc, ipp_departure_time, ipp_travel_time
+				),
+				departure_time % period
+			);
+		};
+
+		cout << "Ready" << endl;
+
+		for(;;){
+			unsigned source_node, source_time, target_node;
+			cin >> source_node >> source_time >> target_node;
+
+			if(source_node > node_count){
+				cout << "source node invalid" << endl;
+				continue;
+			}
+			if(target_node > node_count){
+				cout << "target node invalid" << endl;
+				continue;
+			}
+			if(source_time > period){
+				cout << "source time invalid" << endl;
+				continue;
+			}
+
+			// Consecutive queries with the same source node and source time continue the previous search.
+			// On a contracted graph the arc path consists of original arcs.
+			long long timer = -get_micro_time();
+			bool was_resumed = false;
+			unsigned target_time;
+			vector<unsigned>path;
+			if(is_contracted){
+				target_time = chains->run(dij, source_node, source_time, target_node, get_td_weight, path);
+			}else{
+				was_resumed = dij.run_or_resume(source_node, source_time, target_node, get_td_weight);
+				target_time = dij.distance_to(target_node);
+				path = dij.arc_path_to(target_node);
+			}
+			timer += get_micro_time();
+
+			cout
+				<< "source node : " << source_node << '\n'
+				<< "source time [ms since midnight] : " << source_time << '\n'
+				<< "target node : " << target_node << '\n'
+				<< "search resumed : " << (was_resumed ? "yes" : "no") << '\n'
+				<< "Dijkstra running time [musec] : " << timer << '\n';
+			if(target_time == inf_weight){
+				cout << "No path" << endl;
+			} else {
+				cout
+					<< "Exact target time [ms since midnight] : " << target_time << '\n'
+					<< "Exact travel time [ms since midnight] : " << (target_time-source_time) << '\n'
+					<< "Exact arc path :";
+				for(auto a:path)
+					cout << ' ' << a;
+				cout << endl;
+			}
+		}
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+	}
+}
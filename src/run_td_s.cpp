@@ -5,6 +5,10 @@
 
 #include "ipp.h"
 #include "dijkstra.h"
+#include "td_s_cache.h"
+#include "statistics.h"
+#include "numa.h"
+#include "geo_index.h"
 #include "verify.h"
 
 #include <iostream>
@@ -14,6 +18,8 @@
 #include <cstdlib>
 #include <cassert>
 #include <random>
+#include <memory>
+#include <algorithm>
 using namespace std;
 using namespace RoutingKit;
 
@@ -24,23 +30,69 @@ int main(int argc, char*argv[]){
 		const unsigned period = 24*60*60*1000;
 		vector<unsigned>first_out, head, first_ipp_of_arc, ipp_departure_time, ipp_travel_time;
 
-		if(argc <= 6){
+		// A query budget of 0 means that the budget is unlimited.
+		unsigned max_settled_node_count = 0;
+		long long deadline = 0;
+
+		// A result cache capacity of 0 disables the cache.
+		unsigned result_cache_capacity = 0;
+		unsigned result_cache_bucket_length = 15*60*1000;
+
+		// A corridor cache capacity of 0 disables the cache.
+		unsigned corridor_cache_capacity = 0;
+
+		// An empty placement keeps the data where it was loaded.
+		string numa_placement;
+		unsigned numa_node = 0;
+		bool use_huge_pages = false;
+
+		// Without coordinates the queries are given as node IDs.
+		vector<float>latitude, longitude;
+
+		vector<string>file_list;
+		for(int i=1; i<argc; ++i){
+			string arg = argv[i];
+			if(arg == "--max-settled-nodes" && i+1 < argc)
+				max_settled_node_count = stoul(argv[++i]);
+			else if(arg == "--deadline" && i+1 < argc)
+				deadline = stoll(argv[++i]);
+			else if(arg == "--result-cache" && i+1 < argc)
+				result_cache_capacity = stoul(argv[++i]);
+			else if(arg == "--result-cache-bucket" && i+1 < argc)
+				result_cache_bucket_length = stoul(argv[++i]);
+			else if(arg == "--corridor-cache" && i+1 < argc)
+				corridor_cache_capacity = stoul(argv[++i]);
+			else if(arg == "--numa" && i+1 < argc)
+				numa_placement = argv[++i];
+			else if(arg == "--numa-node" && i+1 < argc)
+				numa_node = stoul(argv[++i]);
+			else if(arg == "--huge-pages")
+				use_huge_pages = true;
+			else if(arg == "--coordinates" && i+2 < argc){
+				latitude = load_vector<float>(argv[++i]);
+				longitude = load_vector<float>(argv[++i]);
+			}
+			else
+				file_list.push_back(move(arg));
+		}
+
+		if(file_list.size() <= 5){
 			cerr 
 				<< "Usage : \n"
-				<< argv[0] << " first_out head first_ipp_of_arc ipp_departure_time ipp_travel_time time_window_ch1 [time_window_ch2 [...]]" << endl;
+				<< argv[0] << " [--max-settled-nodes count] [--deadline musec] [--result-cache entry_count [--result-cache-bucket ms]] [--corridor-cache entry_count] [--numa replicate|interleave [--numa-node node]] [--huge-pages] [--coordinates latitude longitude] first_out head first_ipp_of_arc ipp_departure_time ipp_travel_time time_window_ch1 [time_window_ch2 [...]]" << endl;
 			return 1;
 		}else{
 			cerr << "Loading ... " << flush;	
-			first_out = load_vector<unsigned>(argv[1]);
-			head = load_vector<unsigned>(argv[2]);
-			first_ipp_of_arc = load_vector<unsigned>(argv[3]);
-			ipp_departure_time = load_vector<unsigned>(argv[4]);
-			ipp_travel_time = load_vector<unsigned>(argv[5]);
+			first_out = load_vector<unsigned>(file_list[0]);
+			head = load_vector<unsigned>(file_list[1]);
+			first_ipp_of_arc = load_vector<unsigned>(file_list[2]);
+			ipp_departure_time = load_vector<unsigned>(file_list[3]);
+			ipp_travel_time = load_vector<unsigned>(file_list[4]);
 
-			ch.resize(argc-6);
+			ch.resize(file_list.size()-5);
 
-			for(int i=6; i<argc; ++i)
-				ch[i-6] = ContractionHierarchy::load_file(argv[i]);
+			for(unsigned i=5; i<file_list.size(); ++i)
+				ch[i-5] = ContractionHierarchy::load_file(file_list[i]);
 			cerr << "done" << endl;
 		}
 		
@@ -50,10 +102,100 @@ int main(int argc, char*argv[]){
 		const unsigned arc_count = head.size();
 		const unsigned time_window_count = ch.size();
 
+		if(result_cache_bucket_length == 0)
+			throw runtime_error("result cache bucket length must not be zero");
+
 		for(auto&x:ch)
 			if(x.node_count() != node_count)
 				throw runtime_error("CH has wrong number of nodes");
 
+		unique_ptr<GeoIndex>geo_index;
+		if(!latitude.empty() || !longitude.empty()){
+			if(latitude.size() != node_count || longitude.size() != node_count)
+				throw runtime_error("latitude and longitude must have one entry per node");
+			geo_index.reset(new GeoIndex(latitude, longitude));
+		}
+
+		if(!numa_placement.empty() && numa_placement != "replicate" && numa_placement != "interleave")
+			throw runtime_error("NUMA placement must be replicate or interleave");
+
+		const unsigned numa_node_count = get_numa_node_count();
+		if(numa_node >= numa_node_count)
+			throw runtime_error("NUMA node does not exist");
+
+		{
+			vector<vector<unsigned>*>graph_data = {&first_out, &head, &first_ipp_of_arc, &ipp_departure_time, &ipp_travel_time};
+			// The shortcut bit vectors need one bit per arc and are left where they are.
+			vector<vector<unsigned>*>ch_data;
+			for(auto&x:ch)
+				for(auto v:{&x.rank, &x.order, &x.forward.first_out, &x.forward.head, &x.forward.weight, &x.forward.shortcut_first_arc, &x.forward.shortcut_second_arc, &x.backward.first_out, &x.backward.head, &x.backward.weight, &x.backward.shortcut_first_arc, &x.backward.shortcut_second_arc})
+					ch_data.push_back(v);
+
+			unsigned long long graph_memory = 0;
+			for(auto v:graph_data)
+				graph_memory += get_vector_memory_usage(*v);
+			unsigned long long ch_memory = 0;
+			for(auto v:ch_data)
+				ch_memory += get_vector_memory_usage(*v);
+
+			// The queries are answered by a single thread. Replication therefore pins this thread
+			// and places one copy of the data on its node.
+			if(numa_placement == "replicate"){
+				pin_current_thread_to_numa_node(numa_node);
+				for(auto v:graph_data)
+					*v = copy_on_numa_node(*v, numa_node);
+				for(auto&x:ch)
+					x = copy_on_numa_node(x, numa_node);
+			}else if(numa_placement == "interleave"){
+				for(auto v:graph_data)
+					if(!interleave_over_numa_nodes(*v))
+						throw runtime_error("could not interleave the graph over the NUMA nodes");
+				for(auto v:ch_data)
+					if(!interleave_over_numa_nodes(*v))
+						throw runtime_error("could not interleave the CHs over the NUMA nodes");
+			}
+
+			unsigned huge_page_vector_count = 0;
+			if(use_huge_pages)
+				for(auto v:graph_data)
+					if(advise_huge_pages(*v))
+						++huge_page_vector_count;
+
+			if(!numa_placement.empty() || use_huge_pages){
+				// The memory per node is measured and not derived from the placement, as the kernel
+				// falls back to other nodes if a node runs out of memory.
+				vector<unsigned long long>graph_memory_of_node(numa_node_count, 0), ch_memory_of_node(numa_node_count, 0);
+				bool is_residency_known = true;
+				for(auto v:graph_data)
+					is_residency_known = add_numa_node_residency(*v, graph_memory_of_node) && is_residency_known;
+				for(auto v:ch_data)
+					is_residency_known = add_numa_node_residency(*v, ch_memory_of_node) && is_residency_known;
+				unsigned reported_node_count = max(graph_memory_of_node.size(), ch_memory_of_node.size());
+				graph_memory_of_node.resize(reported_node_count, 0);
+				ch_memory_of_node.resize(reported_node_count, 0);
+
+				if(is_residency_known && numa_placement == "replicate")
+					for(unsigned n=0; n<reported_node_count; ++n)
+						if(n != numa_node && graph_memory_of_node[n] + ch_memory_of_node[n] != 0)
+							throw runtime_error("could not place the graph and the CHs on NUMA node "+to_string(numa_node));
+
+				cerr
+					<< "NUMA node count : " << numa_node_count << '\n'
+					<< "NUMA placement : " << numa_placement << '\n'
+					<< "graph memory [byte] : " << graph_memory << '\n'
+					<< "CH memory [byte] : " << ch_memory << '\n';
+				if(is_residency_known){
+					for(unsigned n=0; n<reported_node_count; ++n)
+						cerr
+							<< "graph memory on NUMA node " << n << " [byte] : " << graph_memory_of_node[n] << '\n'
+							<< "CH memory on NUMA node " << n << " [byte] : " << ch_memory_of_node[n] << '\n';
+				}else{
+					cerr << "memory per NUMA node : unknown, the kernel does not report page locations" << '\n';
+				}
+				cerr << "huge page backed graph vectors : " << huge_page_vector_count << " of " << graph_data.size() << endl;
+			}
+		}
+
 		ContractionHierarchyQuery ch_query;
 		ch_query.reset(ch[0]);
 
@@ -79,11 +221,56 @@ int main(int argc, char*argv[]){
 				return inf_weight;
 		};
 
+		auto compute_target_time_along_path = [&](unsigned source_time, const vector<unsigned>&path){
+			unsigned target_time = source_time;
+			for(auto arc:path)
+				target_time += get_td_weight(arc, target_time);
+			return target_time;
+		};
+
+		long long query_begin_time = 0;
+
+		// The clock is only read every 256 settled nodes to keep the overhead low.
+		auto is_out_of_budget = [&](unsigned settled_node_count){
+			if(max_settled_node_count != 0 && settled_node_count >= max_settled_node_count)
+				return true;
+			if(deadline != 0 && settled_node_count % 256 == 0 && get_micro_time() - query_begin_time >= deadline)
+				return true;
+			return false;
+		};
+
+		// The arc weights of this tool never change and therefore the version is always 0.
+		const unsigned weight_version = 0;
+		unique_ptr<TDSResultCache>result_cache;
+		if(result_cache_capacity != 0)
+			result_cache.reset(new TDSResultCache(result_cache_capacity));
+		unique_ptr<TDSCorridorCache>corridor_cache;
+		if(corridor_cache_capacity != 0)
+			corridor_cache.reset(new TDSCorridorCache(corridor_cache_capacity));
+
 		cout << "Ready" << endl;
 
 		for(;;){
 			unsigned source_node, source_time, target_node;
-			cin >> source_node >> source_time >> target_node;
+			GeoIndex::NearestNode source_snap, target_snap;
+			if(geo_index){
+				float source_latitude, source_longitude, target_latitude, target_longitude;
+				cin >> source_latitude >> source_longitude >> source_time >> target_latitude >> target_longitude;
+				if(!is_valid_coordinate(source_latitude, source_longitude)){
+					cout << "source coordinate invalid" << endl;
+					continue;
+				}
+				if(!is_valid_coordinate(target_latitude, target_longitude)){
+					cout << "target coordinate invalid" << endl;
+					continue;
+				}
+				source_snap = geo_index->find_nearest_node(source_latitude, source_longitude);
+				target_snap = geo_index->find_nearest_node(target_latitude, target_longitude);
+				source_node = source_snap.node;
+				target_node = target_snap.node;
+			}else{
+				cin >> source_node >> source_time >> target_node;
+			}
 
 			if(source_node > node_count){
 				cout << "source node invalid" << endl;
@@ -98,32 +285,150 @@ int main(int argc, char*argv[]){
 				continue;
 			}
 
+			#ifdef TD_S_STATISTICS
+			reset_query_statistics();
+			#endif
+
 			long long baseline_timer = -get_micro_time();
 			dij.run(source_node, source_time, target_node, get_td_weight);
 			unsigned exact_target_time = dij.distance_to(target_node);
 			vector<unsigned>exact_path = dij.arc_path_to(target_node);
 			baseline_timer += get_micro_time();
 
+			#ifdef TD_S_STATISTICS
+			QueryStatistics baseline_statistics = get_query_statistics();
+			reset_query_statistics();
+			vector<long long>window_ch_time(time_window_count, 0);
+			unsigned long long unpacked_path_length = 0;
+			unsigned corridor_arc_count = 0;
+			#endif
+
 			long long td_s_timer = -get_micro_time();
-			for(auto&p:allowed_path_list)
-				for(auto a:p)
-					is_arc_allowed[a] = false;
-			for(unsigned w=0; w<time_window_count; ++w)
-				allowed_path_list[w] = ch_query.reset(ch[w]).add_source(source_node).add_target(target_node).run().get_arc_path();
-			for(auto&p:allowed_path_list)
-				for(auto a:p)
-					is_arc_allowed[a] = true;
-			dij.run(source_node, source_time, target_node, get_pruned_td_weight);
-			unsigned td_s_target_time = dij.distance_to(target_node);
-			vector<unsigned>td_s_path = dij.arc_path_to(target_node);
+			query_begin_time = -td_s_timer;
+			bool is_td_s_cache_hit = false;
+			bool is_td_s_degraded = false;
+			bool is_td_s_corridor_cache_hit = false;
+			unsigned td_s_target_time;
+			vector<unsigned>td_s_path;
+			TDSResultKey result_key = make_td_s_result_key(source_node, target_node, source_time, result_cache_bucket_length, weight_version);
+			TDSResult cached_result;
+			TDSCorridorKey corridor_key = {source_node, target_node};
+			TDSCorridor cached_corridor;
+			if(result_cache && result_cache->get(result_key, cached_result)){
+				// The cached path was computed for another departure time in the same bucket. It is reevaluated for this departure time.
+				is_td_s_cache_hit = true;
+				td_s_path = move(cached_result.arc_path);
+				if(cached_result.target_time == inf_weight)
+					td_s_target_time = inf_weight;
+				else
+					td_s_target_time = compute_target_time_along_path(source_time, td_s_path);
+			}else{
+				for(auto&p:allowed_path_list)
+					for(auto a:p)
+						is_arc_allowed[a] = false;
+				if(corridor_cache && corridor_cache->get(corridor_key, cached_corridor)){
+					is_td_s_corridor_cache_hit = true;
+					extract_td_s_corridor_paths(cached_corridor, allowed_path_list);
+				}else{
+					for(unsigned w=0; w<time_window_count; ++w){
+						#ifdef TD_S_STATISTICS
+						window_ch_time[w] = -get_micro_time();
+						#endif
+						allowed_path_list[w] = ch_query.reset(ch[w]).add_source(source_node).add_target(target_node).run().get_arc_path();
+						#ifdef TD_S_STATISTICS
+						window_ch_time[w] += get_micro_time();
+						#endif
+					}
+					if(corridor_cache)
+						corridor_cache->put(corridor_key, make_td_s_corridor(allowed_path_list));
+				}
+				for(auto&p:allowed_path_list)
+					for(auto a:p)
+						is_arc_allowed[a] = true;
+				#ifdef TD_S_STATISTICS
+				for(auto&p:allowed_path_list){
+					unpacked_path_length += p.size();
+					for(auto a:p){
+						if(is_arc_allowed[a]){
+							is_arc_allowed[a] = false;
+							++corridor_arc_count;
+						}
+					}
+				}
+				for(auto&p:allowed_path_list)
+					for(auto a:p)
+						is_arc_allowed[a] = true;
+				#endif
+				is_td_s_degraded = !dij.run_with_budget(source_node, source_time, target_node, get_pruned_td_weight, is_out_of_budget);
+				if(!is_td_s_degraded){
+					td_s_target_time = dij.distance_to(target_node);
+					td_s_path = dij.arc_path_to(target_node);
+				}else{
+					// Fall back to the window CH path that is fastest with respect to the time-dependent weights.
+					td_s_target_time = inf_weight;
+					for(auto&p:allowed_path_list){
+						if(p.empty())
+							continue;
+						unsigned t = compute_target_time_along_path(source_time, p);
+						if(t < td_s_target_time){
+							td_s_target_time = t;
+							td_s_path = p;
+						}
+					}
+				}
+				if(result_cache && !is_td_s_degraded)
+					result_cache->put(result_key, {td_s_target_time, td_s_path});
+			}
 			td_s_timer  += get_micro_time();
 
+			#ifdef TD_S_STATISTICS
+			{
+				// One JSON object per line so that the statistics can be extracted with grep '^{'.
+				QueryStatistics td_s_statistics = get_query_statistics();
+				cout
+					<< "{\"source_node\":" << source_node
+					<< ",\"source_time\":" << source_time
+					<< ",\"target_node\":" << target_node
+					<< ",\"baseline\":{\"running_time\":" << baseline_timer << ',' << format_query_statistics_as_json_members(baseline_statistics) << '}'
+					<< ",\"td_s\":{\"running_time\":" << td_s_timer << ',' << format_query_statistics_as_json_members(td_s_statistics)
+					<< ",\"window_ch_running_time\":[";
+				for(unsigned w=0; w<time_window_count; ++w){
+					if(w != 0)
+						cout << ',';
+					cout << window_ch_time[w];
+				}
+				cout
+					<< "],\"unpacked_path_length\":" << unpacked_path_length
+					<< ",\"corridor_arc_count\":" << corridor_arc_count
+					<< ",\"result_cache_hit\":" << (is_td_s_cache_hit ? "true" : "false")
+					<< ",\"corridor_cache_hit\":" << (is_td_s_corridor_cache_hit ? "true" : "false")
+					<< ",\"degraded\":" << (is_td_s_degraded ? "true" : "false")
+					<< "}}\n";
+			}
+			#endif
+
 			cout 
 				<< "source node : " << source_node << '\n'
 				<< "source time [ms since midnight] : " << source_time << '\n'
-				<< "target node : " << target_node << '\n'
+				<< "target node : " << target_node << '\n';
+			if(geo_index){
+				cout
+					<< "source snapping distance [m] : " << source_snap.distance << '\n'
+					<< "target snapping distance [m] : " << target_snap.distance << '\n';
+			}
+			cout
 				<< "Dijkstra running time [musec] : " << baseline_timer << '\n'
-				<< "TD-S query running time [musec] : " << td_s_timer  << '\n';
+				<< "TD-S query running time [musec] : " << td_s_timer  << '\n'
+				<< "TD-S degraded : " << (is_td_s_degraded ? "yes" : "no") << '\n'
+				<< "TD-S result cache hit : " << (is_td_s_cache_hit ? "yes" : "no") << '\n'
+				<< "TD-S corridor cache hit : " << (is_td_s_corridor_cache_hit ? "yes" : "no") << '\n';
+			if(corridor_cache){
+				unsigned long long hit_count = corridor_cache->hit_count(), miss_count = corridor_cache->miss_count();
+				cout
+					<< "TD-S corridor cache hit count : " << hit_count << '\n'
+					<< "TD-S corridor cache miss count : " << miss_count << '\n'
+					<< "TD-S corridor cache hit rate [%] : " << 100.0*hit_count/(hit_count+miss_count) << '\n';
+			}
 			if(exact_target_time == inf_weight){
 				cout << "No path" << endl;
 			} else {
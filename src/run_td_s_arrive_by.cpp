@@ -0,0 +1,171 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/contraction_hierarchy.h>
+#include <routingkit/timer.h>
+
+#include "ipp.h"
+#include "dijkstra.h"
+#include "reverse_graph.h"
+#include "verify.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cassert>
+using namespace std;
+using namespace RoutingKit;
+
+int main(int argc, char*argv[]){
+	try{
+
+		vector<ContractionHierarchy>ch;
+		const unsigned period = 24*60*60*1000;
+		vector<unsigned>first_out, head, first_ipp_of_arc, ipp_departure_time, ipp_travel_time;
+
+		if(argc <= 6){
+			cerr
+				<< "Usage : \n"
+				<< argv[0] << " first_out head first_ipp_of_arc ipp_departure_time ipp_travel_time time_window_ch1 [time_window_ch2 [...]]" << endl;
+			return 1;
+		}else{
+			cerr << "Loading ... " << flush;
+			first_out = load_vector<unsigned>(argv[1]);
+			head = load_vector<unsigned>(argv[2]);
+			first_ipp_of_arc = load_vector<unsigned>(argv[3]);
+			ipp_departure_time = load_vector<unsigned>(argv[4]);
+			ipp_travel_time = load_vector<unsigned>(argv[5]);
+
+			ch.resize(argc-6);
+
+			for(int i=6; i<argc; ++i)
+				ch[i-6] = ContractionHierarchy::load_file(argv[i]);
+			cerr << "done" << endl;
+		}
+
+		check_if_td_graph_is_valid(period, first_out, head, first_ipp_of_arc, ipp_departure_time, ipp_travel_time);
+
+		const unsigned node_count = first_out.size()-1;
+		const unsigned arc_count = head.size();
+		const unsigned time_window_count = ch.size();
+
+		for(auto&x:ch)
+			if(x.node_count() != node_count)
+				throw runtime_error("CH has wrong number of nodes");
+
+		ContractionHierarchyQuery ch_query;
+		ch_query.reset(ch[0]);
+
+		vector<bool>is_arc_allowed(arc_count, false);
+		vector<vector<unsigned>>allowed_path_list(time_window_count);
+
+		ReverseGraph reverse_graph = compute_reverse_graph(first_out, head);
+		Dijkstra backward_dij(reverse_graph.first_out, reverse_graph.head);
+
+		// The backward search's keys are the durations between the departure at a node and the target time.
+		unsigned target_time = 0;
+
+		auto get_backward_td_weight = [&](unsigned back_arc, unsigned key){
+			unsigned arrival_time = (target_time + period - key % period) % period;
+			return evaluate_inverse_plf(
+				ArcPLF(
+					reverse_graph.forward_arc[back_arc], period,
+					first_ipp_of_arc, ipp_departure_time, ipp_travel_time
+				),
+				arrival_time
+			);
+		};
+
+		auto get_pruned_backward_td_weight = [&](unsigned back_arc, unsigned key){
+			if(is_arc_allowed[reverse_graph.forward_arc[back_arc]])
+				return get_backward_td_weight(back_arc, key);
+			else
+				return inf_weight;
+		};
+
+		auto get_forward_arc_path = [&](unsigned source_node){
+			vector<unsigned>path = backward_dij.arc_path_to(source_node);
+			reverse(path.begin(), path.end());
+			for(auto&a:path)
+				a = reverse_graph.forward_arc[a];
+			return path;
+		};
+
+		auto compute_target_time_along_path = [&](long long source_time, const vector<unsigned>&path){
+			long long t = source_time;
+			for(auto a:path)
+				t += evaluate_plf(ArcPLF(a, period, first_ipp_of_arc, ipp_departure_time, ipp_travel_time), (t % period + period) % period);
+			return t;
+		};
+
+		cout << "Ready" << endl;
+
+		for(;;){
+			unsigned source_node, target_node;
+			cin >> source_node >> target_time >> target_node;
+
+			if(source_node > node_count){
+				cout << "source node invalid" << endl;
+				continue;
+			}
+			if(target_node > node_count){
+				cout << "target node invalid" << endl;
+				continue;
+			}
+			if(target_time >= period){
+				cout << "target time invalid" << endl;
+				continue;
+			}
+
+			long long baseline_timer = -get_micro_time();
+			backward_dij.run(target_node, 0, source_node, get_backward_td_weight);
+			unsigned exact_duration = backward_dij.distance_to(source_node);
+			vector<unsigned>exact_path = get_forward_arc_path(source_node);
+			baseline_timer += get_micro_time();
+
+			long long td_s_timer = -get_micro_time();
+			for(auto&p:allowed_path_list)
+				for(auto a:p)
+					is_arc_allowed[a] = false;
+			for(unsigned w=0; w<time_window_count; ++w)
+				allowed_path_list[w] = ch_query.reset(ch[w]).add_source(source_node).add_target(target_node).run().get_arc_path();
+			for(auto&p:allowed_path_list)
+				for(auto a:p)
+					is_arc_allowed[a] = true;
+			backward_dij.run(target_node, 0, source_node, get_pruned_backward_td_weight);
+			unsigned td_s_duration = backward_dij.distance_to(source_node);
+			vector<unsigned>td_s_path = get_forward_arc_path(source_node);
+			td_s_timer += get_micro_time();
+
+			cout
+				<< "source node : " << source_node << '\n'
+				<< "target time [ms since midnight] : " << target_time << '\n'
+				<< "target node : " << target_node << '\n'
+				<< "Backward Dijkstra running time [musec] : " << baseline_timer << '\n'
+				<< "TD-S query running time [musec] : " << td_s_timer  << '\n';
+			if(exact_duration == inf_weight){
+				cout << "No path" << endl;
+			} else {
+				// Source times are negative if the departure is on the previous day.
+				long long exact_source_time = static_cast<long long>(target_time) - exact_duration;
+				long long td_s_source_time = static_cast<long long>(target_time) - td_s_duration;
+				cout
+					<< "Exact source time [ms since midnight] : " << exact_source_time << '\n'
+					<< "Exact travel time [ms] : " << (compute_target_time_along_path(exact_source_time, exact_path) - exact_source_time) << '\n'
+					<< "Exact arc path :";
+				for(auto a:exact_path)
+					cout << ' ' << a;
+				cout << endl;
+				cout
+					<< "TD-S source time [ms since midnight] : " << td_s_source_time << '\n'
+					<< "TD-S travel time [ms] : " << (compute_target_time_along_path(td_s_source_time, td_s_path) - td_s_source_time) << '\n'
+					<< "TD-S arc path :";
+				for(auto a:td_s_path)
+					cout << ' ' << a;
+				cout << endl;
+			}
+		}
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+	}
+}
@@ -0,0 +1,478 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/inverse_vector.h>
+#include <routingkit/permutation.h>
+#include <routingkit/contraction_hierarchy.h>
+#include <routingkit/customizable_contraction_hierarchy.h>
+#include <routingkit/timer.h>
+
+#include "ipp.h"
+#include "dijkstra.h"
+#include "numa.h"
+#include "td_s_protocol.h"
+#include "geo_index.h"
+#include "verify.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <cstring>
+#include <cstdlib>
+#include <cassert>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace RoutingKit;
+
+namespace{
+
+const unsigned period = 24*60*60*1000;
+const unsigned sample_step = 10*60*1000;
+
+//! The read-only data that the workers query. With NUMA replication every node has its own copy.
+struct Dataset{
+	vector<unsigned>first_out, head, first_ipp_of_arc, ipp_departure_time, ipp_travel_time;
+	vector<ContractionHierarchy>ch;
+};
+
+//! The CCH path of TD-S+D follows the predicted travel times at the current time of day.
+//! Two metrics are kept. The updater customizes the inactive one and then activates it,
+//! so that queries never wait for a customization.
+struct CurrentMetric{
+	unique_ptr<CustomizableContractionHierarchy>cch;
+	vector<unsigned>weight[2];
+	unique_ptr<CustomizableContractionHierarchyMetric>metric[2];
+	shared_timed_mutex lock[2];
+	atomic<unsigned>active;
+};
+
+class Connection{
+public:
+	explicit Connection(int fd):fd(fd){}
+
+	~Connection(){
+		close(fd);
+	}
+
+	int get_fd()const{
+		return fd;
+	}
+
+	//! Writes complete frames. Errors are ignored, the reader notices closed connections.
+	void write_frames(const vector<unsigned>&frames){
+		lock_guard<mutex>guard(write_lock);
+		const char*data = reinterpret_cast<const char*>(frames.data());
+		size_t byte_count = frames.size()*sizeof(unsigned), done = 0;
+		while(done != byte_count){
+			ssize_t r = send(fd, data + done, byte_count - done, MSG_NOSIGNAL);
+			if(r <= 0)
+				return;
+			done += r;
+		}
+	}
+
+private:
+	int fd;
+	mutex write_lock;
+};
+
+struct Job{
+	shared_ptr<Connection>connection;
+	TDSRequest request;
+};
+
+//! Jobs are pushed and popped in batches to reduce the locking overhead.
+class JobQueue{
+public:
+	void push(vector<Job>&batch){
+		{
+			lock_guard<mutex>guard(lock);
+			for(auto&j:batch)
+				job_list.push_back(move(j));
+		}
+		batch.clear();
+		not_empty.notify_all();
+	}
+
+	void pop(vector<Job>&batch, unsigned max_batch_size){
+		batch.clear();
+		unique_lock<mutex>guard(lock);
+		not_empty.wait(guard, [&]{return !job_list.empty();});
+		while(!job_list.empty() && batch.size() < max_batch_size){
+			batch.push_back(move(job_list.front()));
+			job_list.pop_front();
+		}
+	}
+
+private:
+	mutex lock;
+	condition_variable not_empty;
+	deque<Job>job_list;
+};
+
+unsigned get_current_time_of_day(){
+	time_t now = time(nullptr);
+	tm local;
+	localtime_r(&now, &local);
+	return ((local.tm_hour*60 + local.tm_min)*60 + local.tm_sec)*1000;
+}
+
+//! Coordinate requests are snapped to the nearest nodes here. geo_index is null if the daemon has no coordinates.
+void read_requests(shared_ptr<Connection>connection, JobQueue&job_queue, const GeoIndex*geo_index){
+	vector<char>buffer;
+	vector<Job>batch;
+	vector<unsigned>rejected;
+	char chunk[1 << 16];
+	for(;;){
+		ssize_t r = recv(connection->get_fd(), chunk, sizeof(chunk), 0);
+		if(r <= 0)
+			return;
+		buffer.insert(buffer.end(), chunk, chunk + r);
+
+		// All complete frames that arrived with this read form one batch.
+		size_t pos = 0;
+		for(;;){
+			if(buffer.size() - pos < sizeof(unsigned))
+				break;
+			unsigned frame_size;
+			memcpy(&frame_size, buffer.data() + pos, sizeof(unsigned));
+			if(frame_size > td_s_max_frame_size)
+				return;
+			if(buffer.size() - pos - sizeof(unsigned) < frame_size)
+				break;
+			const char*payload = buffer.data() + pos + sizeof(unsigned);
+			if(frame_size == td_s_request_size){
+				batch.push_back({connection, decode_td_s_request(payload)});
+			}else if(frame_size == td_s_coordinate_request_size){
+				TDSCoordinateRequest q = decode_td_s_coordinate_request(payload);
+				if(geo_index == nullptr || !is_valid_coordinate(q.source_latitude, q.source_longitude) || !is_valid_coordinate(q.target_latitude, q.target_longitude)){
+					append_td_s_response(rejected, q.request_id, td_s_invalid_request);
+				}else{
+					unsigned source_node = geo_index->find_nearest_node(q.source_latitude, q.source_longitude).node;
+					unsigned target_node = geo_index->find_nearest_node(q.target_latitude, q.target_longitude).node;
+					batch.push_back({connection, {q.request_id, q.query_type, source_node, q.source_time, target_node}});
+				}
+			}else{
+				unsigned request_id = 0;
+				if(frame_size >= sizeof(unsigned))
+					memcpy(&request_id, payload, sizeof(unsigned));
+				append_td_s_response(rejected, request_id, td_s_invalid_request);
+			}
+			pos += sizeof(unsigned) + frame_size;
+		}
+		buffer.erase(buffer.begin(), buffer.begin() + pos);
+
+		if(!batch.empty())
+			job_queue.push(batch);
+		if(!rejected.empty()){
+			connection->write_frames(rejected);
+			rejected.clear();
+		}
+	}
+}
+
+void answer_jobs(const Dataset&data, CurrentMetric*current_metric, JobQueue&job_queue, unsigned max_batch_size){
+	const unsigned node_count = data.first_out.size()-1;
+	const unsigned arc_count = data.head.size();
+	const unsigned time_window_count = data.ch.size();
+
+	ContractionHierarchyQuery ch_query;
+	ch_query.reset(data.ch[0]);
+	CustomizableContractionHierarchyQuery cch_query;
+
+	vector<bool>is_arc_allowed(arc_count, false);
+	vector<vector<unsigned>>allowed_path_list(time_window_count+1);
+
+	Dijkstra dij(data.first_out, data.head);
+
+	auto get_td_weight = [&](unsigned arc, unsigned departure_time){
+		return evaluate_plf(
+			ArcPLF(
+				arc, period,
+				data.first_ipp_of_arc, data.ipp_departure_time, data.ipp_travel_time
+			),
+			departure_time % period
+		);
+	};
+
+	auto get_pruned_td_weight = [&](unsigned arc, unsigned departure_time){
+		if(is_arc_allowed[arc])
+			return get_td_weight(arc, departure_time);
+		else
+			return inf_weight;
+	};
+
+	auto compute_corridor = [&](unsigned source_node, unsigned target_node, bool with_current_metric){
+		for(auto&p:allowed_path_list){
+			for(auto a:p)
+				is_arc_allowed[a] = false;
+			p.clear();
+		}
+		for(unsigned w=0; w<time_window_count; ++w)
+			allowed_path_list[w] = ch_query.reset(data.ch[w]).add_source(source_node).add_target(target_node).run().get_arc_path();
+		if(with_current_metric){
+			unsigned m = current_metric->active.load();
+			shared_lock<shared_timed_mutex>guard(current_metric->lock[m]);
+			allowed_path_list[time_window_count] = cch_query.reset(*current_metric->metric[m]).add_source(source_node).add_target(target_node).run().get_arc_path();
+		}
+		for(auto&p:allowed_path_list)
+			for(auto a:p)
+				is_arc_allowed[a] = true;
+	};
+
+	vector<unsigned>body;
+	auto answer = [&](const TDSRequest&q, vector<unsigned>&out){
+		if(q.source_node >= node_count || q.target_node >= node_count || q.source_time > period){
+			append_td_s_response(out, q.request_id, td_s_invalid_request);
+			return;
+		}
+		body.clear();
+		if(q.query_type == td_s_query || q.query_type == td_s_d_query){
+			if(q.query_type == td_s_d_query && current_metric == nullptr){
+				append_td_s_response(out, q.request_id, td_s_unsupported_query_type);
+				return;
+			}
+			compute_corridor(q.source_node, q.target_node, q.query_type == td_s_d_query);
+			dij.run(q.source_node, q.source_time, q.target_node, get_pruned_td_weight);
+			unsigned target_time = dij.distance_to(q.target_node);
+			if(target_time == inf_weight){
+				append_td_s_response(out, q.request_id, td_s_no_path);
+				return;
+			}
+			vector<unsigned>path = dij.arc_path_to(q.target_node);
+			body.push_back(target_time);
+			body.push_back(path.size());
+			body.insert(body.end(), path.begin(), path.end());
+		}else if(q.query_type == td_s_p_query){
+			compute_corridor(q.source_node, q.target_node, false);
+			body.push_back(sample_step);
+			body.push_back(period/sample_step);
+			bool has_path = false;
+			for(unsigned i=0; i<period/sample_step; ++i){
+				dij.run(q.source_node, i*sample_step, q.target_node, get_pruned_td_weight);
+				unsigned target_time = dij.distance_to(q.target_node);
+				if(target_time == inf_weight){
+					body.push_back(inf_weight);
+				}else{
+					body.push_back(target_time - i*sample_step);
+					has_path = true;
+				}
+			}
+			if(!has_path){
+				append_td_s_response(out, q.request_id, td_s_no_path);
+				return;
+			}
+		}else{
+			append_td_s_response(out, q.request_id, td_s_unsupported_query_type);
+			return;
+		}
+		append_td_s_response(out, q.request_id, td_s_ok, body);
+	};
+
+	// The responses of a batch are grouped by connection, so that every connection gets one write per batch.
+	vector<Job>batch;
+	vector<pair<Connection*, vector<unsigned>>>response_list;
+	for(;;){
+		job_queue.pop(batch, max_batch_size);
+		response_list.clear();
+		for(auto&j:batch){
+			unsigned i = 0;
+			while(i < response_list.size() && response_list[i].first != j.connection.get())
+				++i;
+			if(i == response_list.size())
+				response_list.push_back({j.connection.get(), {}});
+			answer(j.request, response_list[i].second);
+		}
+		for(auto&r:response_list)
+			r.first->write_frames(r.second);
+		batch.clear();
+	}
+}
+
+}
+
+int main(int argc, char*argv[]){
+	try{
+		Dataset data;
+		vector<unsigned>cch_order;
+
+		string socket_path = "td_s.sock";
+		unsigned thread_count = thread::hardware_concurrency();
+		unsigned max_batch_size = 64;
+		unsigned cch_update_interval = 60;
+		string numa_placement;
+		vector<float>latitude, longitude;
+
+		vector<string>file_list;
+		for(int i=1; i<argc; ++i){
+			string arg = argv[i];
+			if(arg == "--socket" && i+1 < argc)
+				socket_path = argv[++i];
+			else if(arg == "--threads" && i+1 < argc)
+				thread_count = stoul(argv[++i]);
+			else if(arg == "--batch" && i+1 < argc)
+				max_batch_size = stoul(argv[++i]);
+			else if(arg == "--cch-order" && i+1 < argc)
+				cch_order = load_vector<unsigned>(argv[++i]);
+			else if(arg == "--cch-update-interval" && i+1 < argc)
+				cch_update_interval = stoul(argv[++i]);
+			else if(arg == "--numa" && i+1 < argc)
+				numa_placement = argv[++i];
+			else if(arg == "--coordinates" && i+2 < argc){
+				latitude = load_vector<float>(argv[++i]);
+				longitude = load_vector<float>(argv[++i]);
+			}
+			else
+				file_list.push_back(move(arg));
+		}
+
+		if(file_list.size() <= 5){
+			cerr
+				<< "Usage : \n"
+				<< argv[0] << " [--socket path] [--threads count] [--batch count] [--cch-order file [--cch-update-interval sec]] [--numa replicate] [--coordinates latitude longitude] first_out head first_ipp_of_arc ipp_departure_time ipp_travel_time time_window_ch1 [time_window_ch2 [...]]" << endl;
+			return 1;
+		}else{
+			cerr << "Loading ... " << flush;
+			data.first_out = load_vector<unsigned>(file_list[0]);
+			data.head = load_vector<unsigned>(file_list[1]);
+			data.first_ipp_of_arc = load_vector<unsigned>(file_list[2]);
+			data.ipp_departure_time = load_vector<unsigned>(file_list[3]);
+			data.ipp_travel_time = load_vector<unsigned>(file_list[4]);
+
+			data.ch.resize(file_list.size()-5);
+			for(unsigned i=5; i<file_list.size(); ++i)
+				data.ch[i-5] = ContractionHierarchy::load_file(file_list[i]);
+			cerr << "done" << endl;
+		}
+
+		check_if_td_graph_is_valid(period, data.first_out, data.head, data.first_ipp_of_arc, data.ipp_departure_time, data.ipp_travel_time);
+
+		const unsigned node_count = data.first_out.size()-1;
+		const unsigned arc_count = data.head.size();
+
+		for(auto&x:data.ch)
+			if(x.node_count() != node_count)
+				throw runtime_error("CH has wrong number of nodes");
+		unique_ptr<GeoIndex>geo_index;
+		if(!latitude.empty() || !longitude.empty()){
+			if(latitude.size() != node_count || longitude.size() != node_count)
+				throw runtime_error("latitude and longitude must have one entry per node");
+			geo_index.reset(new GeoIndex(latitude, longitude));
+		}
+		if(thread_count == 0)
+			thread_count = 1;
+		if(max_batch_size == 0)
+			throw runtime_error("the batch size must be positive");
+		if(!numa_placement.empty() && numa_placement != "replicate")
+			throw runtime_error("NUMA placement must be replicate");
+
+		unique_ptr<CurrentMetric>current_metric;
+		if(!cch_order.empty()){
+			if(cch_order.size() != node_count)
+				throw runtime_error("CCH order has wrong size");
+			if(!is_permutation(cch_order))
+				throw runtime_error("CCH order is no permutation");
+
+			cerr << "Building CCH ... " << flush;
+			current_metric.reset(new CurrentMetric);
+			current_metric->cch.reset(new CustomizableContractionHierarchy(cch_order, invert_inverse_vector(data.first_out), data.head));
+			for(unsigned m=0; m<2; ++m){
+				current_metric->weight[m] = compute_time_point_weights(get_current_time_of_day(), period, data.first_ipp_of_arc, data.ipp_departure_time, data.ipp_travel_time);
+				current_metric->metric[m].reset(new CustomizableContractionHierarchyMetric(*current_metric->cch, current_metric->weight[m]));
+			}
+			current_metric->metric[0]->customize();
+			current_metric->active = 0;
+			cerr << "done" << endl;
+		}
+
+		// Every NUMA node gets its own copy of the graph and the CHs. The workers are
+		// distributed round-robin over the nodes and are pinned to the node of their copy.
+		const unsigned numa_node_count = numa_placement == "replicate" ? get_numa_node_count() : 1;
+		vector<unique_ptr<Dataset>>replica(numa_node_count);
+		if(numa_placement == "replicate"){
+			for(unsigned n=0; n<numa_node_count; ++n)
+				replica[n].reset(new Dataset(copy_on_numa_node(data, n)));
+			unsigned long long replica_memory =
+				get_vector_memory_usage(data.first_out) + get_vector_memory_usage(data.head) +
+				get_vector_memory_usage(data.first_ipp_of_arc) + get_vector_memory_usage(data.ipp_departure_time) + get_vector_memory_usage(data.ipp_travel_time);
+			for(unsigned i=5; i<file_list.size(); ++i)
+				replica_memory += ifstream(file_list[i], ios::binary | ios::ate).tellg();
+			cerr
+				<< "NUMA node count : " << numa_node_count << '\n'
+				<< "replica memory per NUMA node [byte] : " << replica_memory << endl;
+			data = Dataset();
+		}else{
+			replica[0].reset(new Dataset(move(data)));
+		}
+
+		int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if(listen_fd < 0)
+			throw runtime_error("could not create socket");
+		sockaddr_un address;
+		memset(&address, 0, sizeof(address));
+		address.sun_family = AF_UNIX;
+		if(socket_path.size() >= sizeof(address.sun_path))
+			throw runtime_error("socket path is too long");
+		strcpy(address.sun_path, socket_path.c_str());
+		unlink(socket_path.c_str());
+		if(::bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+			throw runtime_error("could not bind socket "+socket_path);
+		if(listen(listen_fd, 128) != 0)
+			throw runtime_error("could not listen on socket "+socket_path);
+
+		JobQueue job_queue;
+
+		for(unsigned i=0; i<thread_count; ++i){
+			unsigned n = i % numa_node_count;
+			thread([&, n]{
+				if(numa_placement == "replicate")
+					pin_current_thread_to_numa_node(n);
+				answer_jobs(*replica[n], current_metric.get(), job_queue, max_batch_size);
+			}).detach();
+		}
+
+		if(current_metric && cch_update_interval != 0){
+			thread([&]{
+				for(;;){
+					this_thread::sleep_for(chrono::seconds(cch_update_interval));
+					unsigned m = 1 - current_metric->active.load();
+					unique_lock<shared_timed_mutex>guard(current_metric->lock[m]);
+					// The metric refers to the memory of its weight vector, which therefore must be overwritten in place.
+					vector<unsigned>weight = compute_time_point_weights(get_current_time_of_day(), period, replica[0]->first_ipp_of_arc, replica[0]->ipp_departure_time, replica[0]->ipp_travel_time);
+					copy(weight.begin(), weight.end(), current_metric->weight[m].begin());
+					current_metric->metric[m]->customize();
+					current_metric->active = m;
+				}
+			}).detach();
+		}
+
+		cerr
+			<< "worker thread count : " << thread_count << '\n'
+			<< "arc count : " << arc_count << '\n'
+			<< "Listening on " << socket_path << endl;
+		cout << "Ready" << endl;
+
+		for(;;){
+			int fd = accept(listen_fd, nullptr, nullptr);
+			if(fd < 0)
+				continue;
+			shared_ptr<Connection>connection(new Connection(fd));
+			thread(read_requests, connection, ref(job_queue), geo_index.get()).detach();
+		}
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+	}
+}
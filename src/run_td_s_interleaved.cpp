@@ -0,0 +1,214 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/contraction_hierarchy.h>
+#include <routingkit/timer.h>
+
+#include "ipp.h"
+#include "dijkstra.h"
+#include "interleaved_dijkstra.h"
+#include "verify.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cassert>
+#include <algorithm>
+using namespace std;
+using namespace RoutingKit;
+
+int main(int argc, char*argv[]){
+	try{
+
+		vector<ContractionHierarchy>ch;
+		const unsigned period = 24*60*60*1000;
+		vector<unsigned>first_out, head, first_ipp_of_arc, ipp_departure_time, ipp_travel_time;
+		vector<unsigned>source, source_time, target;
+
+		// The corridor membership of all slots is stored in one byte per arc.
+		const unsigned max_slot_count = 8;
+		unsigned slot_count = max_slot_count;
+
+		vector<string>file_list;
+		for(int i=1; i<argc; ++i){
+			string arg = argv[i];
+			if(arg == "--slots" && i+1 < argc)
+				slot_count = stoul(argv[++i]);
+			else
+				file_list.push_back(move(arg));
+		}
+
+		if(file_list.size() <= 8){
+			cerr
+				<< "Usage : \n"
+				<< argv[0] << " [--slots count] first_out head first_ipp_of_arc ipp_departure_time ipp_travel_time source source_time target time_window_ch1 [time_window_ch2 [...]]" << endl;
+			return 1;
+		}else{
+			cerr << "Loading ... " << flush;
+			first_out = load_vector<unsigned>(file_list[0]);
+			head = load_vector<unsigned>(file_list[1]);
+			first_ipp_of_arc = load_vector<unsigned>(file_list[2]);
+			ipp_departure_time = load_vector<unsigned>(file_list[3]);
+			ipp_travel_time = load_vector<unsigned>(file_list[4]);
+			source = load_vector<unsigned>(file_list[5]);
+			source_time = load_vector<unsigned>(file_list[6]);
+			target = load_vector<unsigned>(file_list[7]);
+
+			ch.resize(file_list.size()-8);
+
+			for(unsigned i=8; i<file_list.size(); ++i)
+				ch[i-8] = ContractionHierarchy::load_file(file_list[i]);
+			cerr << "done" << endl;
+		}
+
+		check_if_td_graph_is_valid(period, first_out, head, first_ipp_of_arc, ipp_departure_time, ipp_travel_time);
+
+		const unsigned node_count = first_out.size()-1;
+		const unsigned arc_count = head.size();
+		const unsigned time_window_count = ch.size();
+		const unsigned query_count = source.size();
+
+		if(source_time.size() != query_count || target.size() != query_count)
+			throw runtime_error("query vectors have different sizes");
+		for(unsigned i=0; i<query_count; ++i){
+			if(source[i] >= node_count || target[i] >= node_count)
+				throw runtime_error("query node invalid");
+			if(source_time[i] >= period)
+				throw runtime_error("source time invalid");
+		}
+		if(slot_count == 0 || slot_count > max_slot_count)
+			throw runtime_error("slot count must be between 1 and "+to_string(max_slot_count));
+
+		for(auto&x:ch)
+			if(x.node_count() != node_count)
+				throw runtime_error("CH has wrong number of nodes");
+
+		// The corridors are computed up front so that only the pruned Dijkstra searches are timed.
+		// The corridor of query i consists of the arcs corridor_arc[first_corridor_arc[i]], ..., corridor_arc[first_corridor_arc[i+1]-1].
+		cerr << "Computing corridors ... " << flush;
+		long long corridor_timer = -get_micro_time();
+		vector<unsigned>first_corridor_arc(query_count+1, 0), corridor_arc;
+		{
+			ContractionHierarchyQuery ch_query;
+			ch_query.reset(ch[0]);
+			vector<bool>is_in_corridor(arc_count, false);
+			for(unsigned i=0; i<query_count; ++i){
+				for(unsigned w=0; w<time_window_count; ++w){
+					for(auto a:ch_query.reset(ch[w]).add_source(source[i]).add_target(target[i]).run().get_arc_path()){
+						if(!is_in_corridor[a]){
+							is_in_corridor[a] = true;
+							corridor_arc.push_back(a);
+						}
+					}
+				}
+				first_corridor_arc[i+1] = corridor_arc.size();
+				for(unsigned j=first_corridor_arc[i]; j<first_corridor_arc[i+1]; ++j)
+					is_in_corridor[corridor_arc[j]] = false;
+			}
+		}
+		corridor_timer += get_micro_time();
+		cerr << "done" << endl;
+
+		// Bit s of is_arc_allowed[a] is set if a is in the corridor of the query in slot s.
+		vector<unsigned char>is_arc_allowed(arc_count, 0);
+
+		auto set_corridor = [&](unsigned query, unsigned slot, bool value){
+			for(unsigned j=first_corridor_arc[query]; j<first_corridor_arc[query+1]; ++j){
+				if(value)
+					is_arc_allowed[corridor_arc[j]] |= (1u << slot);
+				else
+					is_arc_allowed[corridor_arc[j]] &= ~(1u << slot);
+			}
+		};
+
+		auto get_pruned_td_weight = [&](unsigned slot, unsigned arc, unsigned departure_time){
+			if((is_arc_allowed[arc] >> slot) & 1)
+				return evaluate_plf(
+					ArcPLF(
+						arc, period,
+						first_ipp_of_arc, ipp_departure_time, ipp_travel_time
+					),
+					departure_time % period
+				);
+			else
+				return inf_weight;
+		};
+
+		// The first stage loads the position of the arc's IPPs and its corridor flags. The second
+		// stage loads all IPPs of the arc, which covers the binary search of evaluate_plf, but
+		// only if the arc is in the corridor as all other arcs are pruned without evaluation.
+		auto prefetch_arc = [&](unsigned slot, unsigned arc, unsigned stage){
+			if(stage == 1){
+				__builtin_prefetch(&first_ipp_of_arc[arc]);
+				__builtin_prefetch(&is_arc_allowed[arc]);
+			}else if((is_arc_allowed[arc] >> slot) & 1){
+				// 16 unsigned values fill a 64 byte cache line.
+				for(unsigned i=first_ipp_of_arc[arc]; i<first_ipp_of_arc[arc+1]; i+=16){
+					__builtin_prefetch(&ipp_departure_time[i]);
+					__builtin_prefetch(&ipp_travel_time[i]);
+				}
+			}
+		};
+
+		// The searches are allocated before the timers start as initializing their
+		// node arrays is not part of the query running time.
+		Dijkstra sequential_dij(first_out, head);
+		InterleavedDijkstra interleaved_dij(first_out, head, slot_count);
+
+		vector<unsigned>sequential_target_time(query_count), interleaved_target_time(query_count);
+		vector<vector<unsigned>>sequential_path(query_count), interleaved_path(query_count);
+
+		cerr << "Running sequential queries ... " << flush;
+		long long sequential_timer = -get_micro_time();
+		for(unsigned i=0; i<query_count; ++i){
+			set_corridor(i, 0, true);
+			sequential_dij.run(source[i], source_time[i], target[i], [&](unsigned arc, unsigned departure_time){return get_pruned_td_weight(0, arc, departure_time);});
+			sequential_target_time[i] = sequential_dij.distance_to(target[i]);
+			sequential_path[i] = sequential_dij.arc_path_to(target[i]);
+			set_corridor(i, 0, false);
+		}
+		sequential_timer += get_micro_time();
+		cerr << "done" << endl;
+
+		cerr << "Running interleaved queries ... " << flush;
+		long long interleaved_timer = -get_micro_time();
+		interleaved_dij.run(
+			query_count,
+			[&](unsigned slot, unsigned query){
+				set_corridor(query, slot, true);
+				return DijkstraQuery{source[query], source_time[query], target[query]};
+			},
+			get_pruned_td_weight,
+			prefetch_arc,
+			[&](unsigned slot, unsigned query){
+				interleaved_target_time[query] = interleaved_dij.search(slot).distance_to(target[query]);
+				interleaved_path[query] = interleaved_dij.search(slot).arc_path_to(target[query]);
+				set_corridor(query, slot, false);
+			}
+		);
+		interleaved_timer += get_micro_time();
+		cerr << "done" << endl;
+
+		unsigned mismatch_count = 0;
+		for(unsigned i=0; i<query_count; ++i)
+			if(sequential_target_time[i] != interleaved_target_time[i] || sequential_path[i] != interleaved_path[i])
+				++mismatch_count;
+
+		cout
+			<< "query count : " << query_count << '\n'
+			<< "slot count : " << slot_count << '\n'
+			<< "corridor arc count : " << corridor_arc.size() << '\n'
+			<< "corridor running time [musec] : " << corridor_timer << '\n'
+			<< "sequential running time [musec] : " << sequential_timer << '\n'
+			<< "interleaved running time [musec] : " << interleaved_timer << '\n'
+			<< "sequential queries per second : " << (sequential_timer == 0 ? 0.0 : 1e6*query_count/sequential_timer) << '\n'
+			<< "interleaved queries per second : " << (interleaved_timer == 0 ? 0.0 : 1e6*query_count/interleaved_timer) << '\n'
+			<< "speedup : " << (interleaved_timer == 0 ? 0.0 : static_cast<double>(sequential_timer)/interleaved_timer) << '\n'
+			<< "mismatching query count : " << mismatch_count << endl;
+
+		if(mismatch_count != 0)
+			throw runtime_error("interleaved queries produced different results");
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+	}
+}
@@ -0,0 +1,204 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/contraction_hierarchy.h>
+#include <routingkit/timer.h>
+
+#include "ipp.h"
+#include "dijkstra.h"
+#include "ch_one_to_many.h"
+#include "verify.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cassert>
+using namespace std;
+using namespace RoutingKit;
+
+int main(int argc, char*argv[]){
+	try{
+
+		vector<ContractionHierarchy>ch;
+		const unsigned period = 24*60*60*1000;
+		vector<unsigned>first_out, head, first_ipp_of_arc, ipp_departure_time, ipp_travel_time;
+
+		if(argc <= 6){
+			cerr
+				<< "Usage : \n"
+				<< argv[0] << " first_out head first_ipp_of_arc ipp_departure_time ipp_travel_time time_window_ch1 [time_window_ch2 [...]]" << endl;
+			return 1;
+		}else{
+			cerr << "Loading ... " << flush;
+			first_out = load_vector<unsigned>(argv[1]);
+			head = load_vector<unsigned>(argv[2]);
+			first_ipp_of_arc = load_vector<unsigned>(argv[3]);
+			ipp_departure_time = load_vector<unsigned>(argv[4]);
+			ipp_travel_time = load_vector<unsigned>(argv[5]);
+
+			ch.resize(argc-6);
+
+			for(int i=6; i<argc; ++i)
+				ch[i-6] = ContractionHierarchy::load_file(argv[i]);
+			cerr << "done" << endl;
+		}
+
+		check_if_td_graph_is_valid(period, first_out, head, first_ipp_of_arc, ipp_departure_time, ipp_travel_time);
+
+		const unsigned node_count = first_out.size()-1;
+		const unsigned arc_count = head.size();
+		const unsigned time_window_count = ch.size();
+
+		for(auto&x:ch)
+			if(x.node_count() != node_count)
+				throw runtime_error("CH has wrong number of nodes");
+
+		vector<ContractionHierarchyOneToManyQuery>ch_query;
+		for(auto&x:ch)
+			ch_query.emplace_back(x);
+
+		vector<bool>is_arc_allowed(arc_count, false);
+		vector<unsigned>allowed_arc_list;
+
+		Dijkstra dij(first_out, head);
+
+		auto get_td_weight = [&](unsigned arc, unsigned departure_time){
+			return evaluate_plf(
+				ArcPLF(
+					arc, period,
+					first_ipp_of_arc, ipp_departure_time, ipp_travel_time
+				),
+				departure_time % period
+			);
+		};
+
+		auto get_pruned_td_weight = [&](unsigned arc, unsigned departure_time){
+			if(is_arc_allowed[arc])
+				return get_td_weight(arc, departure_time);
+			else
+				return inf_weight;
+		};
+
+		auto print_matrix = [&](const vector<unsigned>&source_list, const vector<unsigned>&target_list, const vector<unsigned>&target_time, unsigned source_time){
+			for(unsigned i=0; i<source_list.size(); ++i){
+				for(unsigned j=0; j<target_list.size(); ++j){
+					if(j != 0)
+						cout << ' ';
+					unsigned t = target_time[i*target_list.size()+j];
+					if(t == inf_weight)
+						cout << '-';
+					else
+						cout << (t - source_time);
+				}
+				cout << '\n';
+			}
+		};
+
+		cout << "Ready" << endl;
+
+		for(;;){
+			unsigned source_time, source_count, target_count;
+			cin >> source_time >> source_count >> target_count;
+
+			vector<unsigned>source_list(source_count), target_list(target_count);
+			for(auto&x:source_list)
+				cin >> x;
+			for(auto&x:target_list)
+				cin >> x;
+
+			if(!cin){
+				cout << "input invalid" << endl;
+				return 1;
+			}
+			if(source_time > period){
+				cout << "source time invalid" << endl;
+				continue;
+			}
+
+			bool is_input_valid = true;
+			for(auto x:source_list)
+				if(x >= node_count)
+					is_input_valid = false;
+			if(!is_input_valid){
+				cout << "source node invalid" << endl;
+				continue;
+			}
+			for(auto x:target_list)
+				if(x >= node_count)
+					is_input_valid = false;
+			if(!is_input_valid){
+				cout << "target node invalid" << endl;
+				continue;
+			}
+
+			vector<unsigned>exact_target_time(source_count*target_count);
+			vector<unsigned>td_s_target_time(source_count*target_count);
+
+			long long baseline_timer = -get_micro_time();
+			for(unsigned i=0; i<source_count; ++i){
+				dij.run_to_all_targets(source_list[i], source_time, target_list, get_td_weight);
+				for(unsigned j=0; j<target_count; ++j)
+					exact_target_time[i*target_count+j] = dij.distance_to(target_list[j]);
+			}
+			baseline_timer += get_micro_time();
+
+			long long corridor_timer = 0;
+			unsigned long long corridor_arc_count = 0;
+
+			long long td_s_timer = -get_micro_time();
+			// The upward search spaces of the targets only depend on the window and are shared by all sources.
+			corridor_timer -= get_micro_time();
+			for(auto&x:ch_query)
+				x.pin_targets(target_list);
+			corridor_timer += get_micro_time();
+			for(unsigned i=0; i<source_count; ++i){
+				// The corridor of a source is the union of the window CH paths to all targets.
+				// A single one-to-many search in this corridor replaces target_count TD-S searches.
+				corridor_timer -= get_micro_time();
+				for(auto a:allowed_arc_list)
+					is_arc_allowed[a] = false;
+				allowed_arc_list.clear();
+				for(unsigned w=0; w<time_window_count; ++w){
+					ch_query[w].run(source_list[i]);
+					for(unsigned j=0; j<target_count; ++j){
+						for(auto a:ch_query[w].get_arc_path(j)){
+							if(!is_arc_allowed[a]){
+								is_arc_allowed[a] = true;
+								allowed_arc_list.push_back(a);
+							}
+						}
+					}
+				}
+				corridor_arc_count += allowed_arc_list.size();
+				corridor_timer += get_micro_time();
+
+				dij.run_to_all_targets(source_list[i], source_time, target_list, get_pruned_td_weight);
+				for(unsigned j=0; j<target_count; ++j)
+					td_s_target_time[i*target_count+j] = dij.distance_to(target_list[j]);
+			}
+			td_s_timer += get_micro_time();
+
+			unsigned long long suboptimal_entry_count = 0;
+			for(unsigned i=0; i<source_count*target_count; ++i)
+				if(td_s_target_time[i] != exact_target_time[i])
+					++suboptimal_entry_count;
+
+			cout
+				<< "source time [ms since midnight] : " << source_time << '\n'
+				<< "source count : " << source_count << '\n'
+				<< "target count : " << target_count << '\n'
+				<< "Dijkstra running time [musec] : " << baseline_timer << '\n'
+				<< "TD-S matrix running time [musec] : " << td_s_timer << '\n'
+				<< "TD-S corridor running time [musec] : " << corridor_timer << '\n'
+				<< "TD-S average corridor arc count : " << (source_count == 0 ? 0 : corridor_arc_count / source_count) << '\n'
+				<< "TD-S suboptimal entry count : " << suboptimal_entry_count << '\n'
+				<< "Exact travel time matrix [ms] :\n";
+			print_matrix(source_list, target_list, exact_target_time, source_time);
+			cout << "TD-S travel time matrix [ms] :\n";
+			print_matrix(source_list, target_list, td_s_target_time, source_time);
+			cout << flush;
+		}
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+	}
+}
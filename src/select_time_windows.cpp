@@ -0,0 +1,212 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/timer.h>
+
+#include "ipp.h"
+#include "dijkstra.h"
+#include "verify.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cassert>
+#include <algorithm>
+using namespace std;
+using namespace RoutingKit;
+
+int main(int argc, char*argv[]){
+	try{
+		const unsigned period = 24*60*60*1000;
+		vector<unsigned>first_out, head, first_ipp_of_arc, ipp_departure_time, ipp_travel_time;
+		vector<unsigned>source, source_time, target, rank;
+		unsigned window_count, candidate_step, max_candidate_length;
+
+		if(argc != 13){
+			cerr
+				<< "Usage : \n"
+				<< argv[0] << " first_out head first_ipp_of_arc ipp_departure_time ipp_travel_time source source_time target rank window_count candidate_step_in_minutes max_window_length_in_minutes\n"
+				<< "Example : " << argv[0] << " input/{first_out,head,first_ipp_of_arc,ipp_departure_time,ipp_travel_time} rank/{source,source_time,target,rank} 4 30 360" << endl;
+			return 1;
+		}else{
+			cout << "Loading ... " << flush;
+			first_out = load_vector<unsigned>(argv[1]);
+			head = load_vector<unsigned>(argv[2]);
+			first_ipp_of_arc = load_vector<unsigned>(argv[3]);
+			ipp_departure_time = load_vector<unsigned>(argv[4]);
+			ipp_travel_time = load_vector<unsigned>(argv[5]);
+			source = load_vector<unsigned>(argv[6]);
+			source_time = load_vector<unsigned>(argv[7]);
+			target = load_vector<unsigned>(argv[8]);
+			rank = load_vector<unsigned>(argv[9]);
+			window_count = stoul(argv[10]);
+			candidate_step = stoul(argv[11]);
+			max_candidate_length = stoul(argv[12]);
+			cout << "done" << endl;
+		}
+
+		cout << "Validity tests ... " << flush;
+		check_if_td_graph_is_valid(period, first_out, head, first_ipp_of_arc, ipp_departure_time, ipp_travel_time);
+
+		const unsigned node_count = first_out.size()-1;
+		const unsigned arc_count = head.size();
+		const unsigned query_count = source.size();
+
+		check_if_sst_queries_are_valid(period, node_count, source, source_time, target, rank);
+
+		if(window_count == 0)
+			throw runtime_error("the window count must be positive");
+		if(candidate_step == 0 || (24*60) % candidate_step != 0)
+			throw runtime_error("the candidate step must divide a day");
+		if(max_candidate_length < candidate_step)
+			throw runtime_error("the maximum window length must be at least the candidate step");
+		cout << "done" << endl;
+
+		// The candidates are all windows [b, e) with b and e multiples of the step that do not wrap around midnight.
+		vector<unsigned>candidate_begin, candidate_end;
+		for(unsigned b=0; b<24*60; b+=candidate_step)
+			for(unsigned e=b+candidate_step; e<=24*60 && e-b<=max_candidate_length; e+=candidate_step){
+				candidate_begin.push_back(b);
+				candidate_end.push_back(e);
+			}
+		const unsigned candidate_count = candidate_begin.size();
+
+		auto get_td_weight = [&](unsigned arc, unsigned departure_time){
+			return evaluate_plf(
+				ArcPLF(
+					arc, period,
+					first_ipp_of_arc, ipp_departure_time, ipp_travel_time
+				),
+				departure_time % period
+			);
+		};
+
+		cout << "Computing exact arrival times ... " << flush;
+		vector<unsigned>exact_target_time(query_count);
+		#pragma omp parallel
+		{
+			Dijkstra dij(first_out, head);
+			#pragma omp for schedule(dynamic)
+			for(unsigned q=0; q<query_count; ++q){
+				dij.run(source[q], source_time[q], target[q], get_td_weight);
+				exact_target_time[q] = dij.distance_to(target[q]);
+			}
+		}
+		cout << "done" << endl;
+
+		// The window CH path equals the shortest path with respect to the window weights.
+		// It is therefore computed with Dijkstra instead of building a CH for every candidate.
+		cout << "Computing paths of " << candidate_count << " candidate windows ... " << flush;
+		long long path_timer = -get_micro_time();
+		vector<unsigned long long>ipp_prefix_integral = compute_ipp_prefix_integral_times_two(period, first_ipp_of_arc, ipp_departure_time, ipp_travel_time);
+		vector<vector<vector<unsigned>>>candidate_path(candidate_count, vector<vector<unsigned>>(query_count));
+		#pragma omp parallel
+		{
+			Dijkstra dij(first_out, head);
+			#pragma omp for schedule(dynamic)
+			for(unsigned c=0; c<candidate_count; ++c){
+				vector<unsigned>weight = compute_time_window_avg_weights_using_prefix(
+					candidate_begin[c]*60*1000, candidate_end[c]*60*1000,
+					period, first_ipp_of_arc, ipp_departure_time, ipp_travel_time,
+					ipp_prefix_integral
+				);
+				auto get_window_weight = [&](unsigned arc, unsigned){
+					return weight[arc];
+				};
+				for(unsigned q=0; q<query_count; ++q){
+					if(exact_target_time[q] == inf_weight)
+						continue;
+					dij.run(source[q], 0, target[q], get_window_weight);
+					candidate_path[c][q] = dij.arc_path_to(target[q]);
+				}
+			}
+		}
+		path_timer += get_micro_time();
+		cout << "done" << endl;
+
+		// Greedily adds the candidate that minimizes the sum of relative errors
+		// of TD-S restricted to the union of the paths of the selected windows.
+		cout << "Selecting windows ... " << endl;
+		long long select_timer = -get_micro_time();
+		vector<unsigned>selected;
+		vector<bool>is_selected(candidate_count, false);
+
+		for(unsigned round=0; round<window_count && round<candidate_count; ++round){
+			vector<double>error_sum(candidate_count, 0.0);
+			vector<unsigned>wrong_count(candidate_count, 0);
+
+			#pragma omp parallel
+			{
+				Dijkstra dij(first_out, head);
+				vector<bool>is_arc_allowed(arc_count, false);
+				auto get_pruned_td_weight = [&](unsigned arc, unsigned departure_time){
+					if(is_arc_allowed[arc])
+						return get_td_weight(arc, departure_time);
+					else
+						return inf_weight;
+				};
+
+				#pragma omp for schedule(dynamic)
+				for(unsigned c=0; c<candidate_count; ++c){
+					if(is_selected[c])
+						continue;
+					for(unsigned q=0; q<query_count; ++q){
+						if(exact_target_time[q] == inf_weight)
+							continue;
+						for(auto s:selected)
+							for(auto a:candidate_path[s][q])
+								is_arc_allowed[a] = true;
+						for(auto a:candidate_path[c][q])
+							is_arc_allowed[a] = true;
+
+						dij.run(source[q], source_time[q], target[q], get_pruned_td_weight);
+						unsigned td_s_target_time = dij.distance_to(target[q]);
+
+						for(auto s:selected)
+							for(auto a:candidate_path[s][q])
+								is_arc_allowed[a] = false;
+						for(auto a:candidate_path[c][q])
+							is_arc_allowed[a] = false;
+
+						if(td_s_target_time != exact_target_time[q]){
+							++wrong_count[c];
+							unsigned exact_travel_time = exact_target_time[q] - source_time[q];
+							if(exact_travel_time != 0)
+								error_sum[c] += static_cast<double>(td_s_target_time - exact_target_time[q]) / exact_travel_time;
+						}
+					}
+				}
+			}
+
+			unsigned best = invalid_id;
+			for(unsigned c=0; c<candidate_count; ++c)
+				if(!is_selected[c] && (best == invalid_id || error_sum[c] < error_sum[best]))
+					best = c;
+
+			selected.push_back(best);
+			is_selected[best] = true;
+
+			cout
+				<< "window " << round << " : " << candidate_begin[best] << "_" << candidate_end[best]
+				<< " ; avg rel error [%] : " << 100.0*error_sum[best]/query_count
+				<< " ; wrong answers [%] : " << 100.0*wrong_count[best]/query_count << endl;
+
+			if(error_sum[best] == 0)
+				break;
+		}
+		select_timer += get_micro_time();
+
+		cout
+			<< "candidate window count : " << candidate_count << '\n'
+			<< "query count : " << query_count << '\n'
+			<< "path running time [musec] : " << path_timer << '\n'
+			<< "selection running time [musec] : " << select_timer << '\n'
+			<< "selected windows [min] :";
+		for(auto s:selected)
+			cout << ' ' << candidate_begin[s] << "_" << candidate_end[s];
+		cout << endl;
+
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+	}
+}
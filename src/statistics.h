@@ -0,0 +1,56 @@
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+// Query statistics are only collected if TD_S_STATISTICS is defined, for example, by adding
+// -DTD_S_STATISTICS to the compiler options. Otherwise all counting macros expand to nothing.
+
+#ifdef TD_S_STATISTICS
+
+#include <string>
+
+struct QueryStatistics{
+	unsigned long long dijkstra_pop_count = 0;
+	unsigned long long dijkstra_push_count = 0;
+	unsigned long long dijkstra_decrease_key_count = 0;
+	unsigned long long dijkstra_relaxed_arc_count = 0;
+	unsigned long long dijkstra_pruned_arc_count = 0;
+	unsigned long long plf_evaluation_count = 0;
+	unsigned long long plf_binary_search_step_count = 0;
+	unsigned long long plf_wrap_around_count = 0;
+};
+
+//! The statistics are per thread so that counting needs no synchronization.
+inline
+QueryStatistics&get_query_statistics(){
+	static thread_local QueryStatistics statistics;
+	return statistics;
+}
+
+inline
+void reset_query_statistics(){
+	get_query_statistics() = QueryStatistics();
+}
+
+//! Formats the counters as the members of a JSON object without the enclosing braces.
+inline
+std::string format_query_statistics_as_json_members(const QueryStatistics&s){
+	return
+		"\"dijkstra_pop_count\":" + std::to_string(s.dijkstra_pop_count) +
+		",\"dijkstra_push_count\":" + std::to_string(s.dijkstra_push_count) +
+		",\"dijkstra_decrease_key_count\":" + std::to_string(s.dijkstra_decrease_key_count) +
+		",\"dijkstra_relaxed_arc_count\":" + std::to_string(s.dijkstra_relaxed_arc_count) +
+		",\"dijkstra_pruned_arc_count\":" + std::to_string(s.dijkstra_pruned_arc_count) +
+		",\"plf_evaluation_count\":" + std::to_string(s.plf_evaluation_count) +
+		",\"plf_binary_search_step_count\":" + std::to_string(s.plf_binary_search_step_count) +
+		",\"plf_wrap_around_count\":" + std::to_string(s.plf_wrap_around_count);
+}
+
+#define TD_S_COUNT(counter) (++get_query_statistics().counter)
+
+#else
+
+#define TD_S_COUNT(counter) ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,136 @@
+#include "ipp.h"
+#include "vector_stream.h"
+
+#include <routingkit/timer.h>
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdlib>
+#include <cassert>
+
+using namespace std;
+using namespace RoutingKit;
+
+int main(int argc, char*argv[]){
+	try{
+		const unsigned period = 24*60*60*1000;
+
+		unsigned long long chunk_size;
+		string first_ipp_of_arc_file, ipp_departure_time_file, ipp_travel_time_file;
+		string min_weight_file, max_weight_file;
+		vector<unsigned>window_begin, window_end;
+		vector<string>window_weight_file;
+
+		if(argc < 7 || (argc-7) % 3 != 0){
+			cerr << argv[0] << " chunk_size_in_mb first_ipp_of_arc_file ipp_departure_time_file ipp_travel_time_file min_weight_file max_weight_file [window_begin window_end weight_file]...\n"
+				<< "Usage: " << argv[0] << " 64 td/{first_ipp_of_arc,ipp_departure_time,ipp_travel_time} freeflow max "
+				<< 0 << " " << 5*60*60*1000 << " win4/0_5 " << 6*60*60*1000 << " " << 9*60*60*1000 << " win4/6_9\n"
+				<< "window_begin and window_end are in milliseconds since the begin of the day.\n"
+				<< "The input is read and the output written in chunks, so the IPP arrays do not need to fit into memory." << endl;
+			return 1;
+		} else {
+			chunk_size = stoull(argv[1]) << 20;
+			first_ipp_of_arc_file = argv[2];
+			ipp_departure_time_file = argv[3];
+			ipp_travel_time_file = argv[4];
+			min_weight_file = argv[5];
+			max_weight_file = argv[6];
+			for(int i=7; i<argc; i+=3){
+				window_begin.push_back(stoul(argv[i]));
+				window_end.push_back(stoul(argv[i+1]));
+				window_weight_file.push_back(argv[i+2]);
+			}
+		}
+
+		const unsigned window_count = window_begin.size();
+
+		for(unsigned w=0; w<window_count; ++w){
+			if(window_end[w] <= window_begin[w])
+				throw runtime_error("window begin must be before window end");
+			if(period < window_end[w])
+				throw runtime_error("window end must be smaller than the period");
+		}
+		if(chunk_size == 0)
+			throw runtime_error("the chunk size must be positive");
+
+		VectorStreamReader<unsigned>first_ipp_of_arc(first_ipp_of_arc_file, chunk_size);
+		VectorStreamReader<unsigned>ipp_departure_time(ipp_departure_time_file, chunk_size);
+		VectorStreamReader<unsigned>ipp_travel_time(ipp_travel_time_file, chunk_size);
+
+		if(first_ipp_of_arc.size() == 0)
+			throw runtime_error("first_ipp_of_arc must not be empty");
+		if(ipp_travel_time.size() != ipp_departure_time.size())
+			throw runtime_error("ipp_travel_time.size() must be ipp_departure_time.size()");
+
+		VectorStreamWriter<unsigned>min_weight(min_weight_file, chunk_size);
+		VectorStreamWriter<unsigned>max_weight(max_weight_file, chunk_size);
+		vector<unique_ptr<VectorStreamWriter<unsigned>>>window_weight;
+		for(unsigned w=0; w<window_count; ++w)
+			window_weight.emplace_back(new VectorStreamWriter<unsigned>(window_weight_file[w], chunk_size));
+
+		cout << "Streaming ... " << flush;
+		long long timer = -get_micro_time();
+
+		// The checks are those of check_if_arc_ipp_are_valid, applied one arc at a time.
+		const unsigned long long ipp_count = ipp_departure_time.size();
+		unsigned long long arc_count = 0;
+		unsigned ipp_begin = first_ipp_of_arc.next();
+		if(ipp_begin != 0)
+			throw runtime_error("first_ipp_of_arc[0] must be 0");
+
+		vector<IPP>ipp_list;
+		while(first_ipp_of_arc.has_next()){
+			unsigned ipp_end = first_ipp_of_arc.next();
+			if(ipp_end < ipp_begin)
+				throw runtime_error("first_ipp_of_arc must be sorted");
+			if(ipp_end == ipp_begin)
+				throw runtime_error("every arc must have at least one ipp");
+			if(ipp_end > ipp_count)
+				throw runtime_error("first_ipp_of_arc.back() must be ipp_departure_time.size()");
+
+			ipp_list.clear();
+			for(unsigned i=ipp_begin; i<ipp_end; ++i){
+				IPP p;
+				p.departure_time = ipp_departure_time.next();
+				p.travel_time = ipp_travel_time.next();
+				if(p.departure_time >= period)
+					throw runtime_error("ipp_departure_time must be smaller than the period");
+				if(!ipp_list.empty() && p.departure_time < ipp_list.back().departure_time)
+					throw runtime_error("ipp_departure_time of every arc must be sorted");
+				ipp_list.push_back(p);
+			}
+
+			auto plf = make_plf(period, ipp_list);
+			min_weight.push_back(minimum_of_plf(plf));
+			max_weight.push_back(maximum_of_plf(plf));
+			for(unsigned w=0; w<window_count; ++w)
+				window_weight[w]->push_back(integral_of_plf(plf, window_begin[w], window_end[w]) / (window_end[w] - window_begin[w]));
+
+			ipp_begin = ipp_end;
+			++arc_count;
+		}
+		if(ipp_begin != ipp_count)
+			throw runtime_error("first_ipp_of_arc.back() must be ipp_departure_time.size()");
+
+		min_weight.finish();
+		max_weight.finish();
+		for(auto&w:window_weight)
+			w->finish();
+
+		timer += get_micro_time();
+		cout << "done" << endl;
+
+		cout
+			<< "arc count : " << arc_count << '\n'
+			<< "ipp count : " << ipp_count << '\n'
+			<< "window count : " << window_count << '\n'
+			<< "chunk size [byte] : " << chunk_size << '\n'
+			<< "running time [musec] : " << timer << endl;
+
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+	}
+}
@@ -0,0 +1,432 @@
+#ifndef TD_CCH_H
+#define TD_CCH_H
+
+#include <routingkit/constants.h>
+
+#include "ipp.h"
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <cassert>
+
+using RoutingKit::invalid_id;
+using RoutingKit::inf_weight;
+
+//! An exact time-dependent customizable contraction hierarchy.
+//! The nodes are contracted in the given order. Every arc of the resulting chordal
+//! supergraph carries one plf for the upward and one plf for the downward direction.
+//! A plf without interpolation points represents an infinite travel time.
+//! Internally all nodes are identified by their rank.
+class TimeDependentCCH{
+public:
+	TimeDependentCCH(
+		unsigned period,
+		const std::vector<unsigned>&order,
+		const std::vector<unsigned>&first_out, const std::vector<unsigned>&head,
+		const std::vector<unsigned>&first_ipp_of_arc, const std::vector<unsigned>&ipp_departure_time, const std::vector<unsigned>&ipp_travel_time
+	):
+		period_(period),
+		rank(order.size()),
+		parent(order.size(), invalid_id),
+		first_out(first_out), head(head),
+		first_ipp_of_arc(first_ipp_of_arc), ipp_departure_time(ipp_departure_time), ipp_travel_time(ipp_travel_time)
+	{
+		const unsigned node_count = order.size();
+		if(first_out.size() != node_count+1)
+			throw std::runtime_error("order has wrong size");
+
+		for(unsigned r=0; r<node_count; ++r)
+			rank[order[r]] = r;
+
+		build_chordal_supergraph();
+		customize();
+	}
+
+	unsigned node_count()const{
+		return rank.size();
+	}
+
+	unsigned cch_arc_count()const{
+		return up_head.size();
+	}
+
+	unsigned ipp_count()const{
+		return up_ipp.size() + down_ipp.size();
+	}
+
+	//! Memory used by the customized hierarchy in bytes.
+	unsigned long long memory_usage()const{
+		return
+			sizeof(unsigned)*(rank.size() + parent.size() + up_first_out.size() + up_head.size() + down_first_out.size() + down_tail.size() + down_to_up.size()) +
+			sizeof(unsigned)*(first_up_ipp.size() + first_down_ipp.size()) +
+			sizeof(IPP)*(up_ipp.size() + down_ipp.size()) +
+			sizeof(unsigned)*(first_up_input_arc.size() + up_input_arc.size() + first_down_input_arc.size() + down_input_arc.size());
+	}
+
+private:
+	friend class TimeDependentCCHQuery;
+
+	// Finds the cch arc between the ranks x and y with x < y.
+	unsigned find_cch_arc(unsigned x, unsigned y)const{
+		assert(x < y);
+		auto begin = up_head.begin()+up_first_out[x], end = up_head.begin()+up_first_out[x+1];
+		auto pos = std::lower_bound(begin, end, y);
+		assert(pos != end && *pos == y);
+		return pos - up_head.begin();
+	}
+
+	void build_chordal_supergraph(){
+		const unsigned node_count = rank.size();
+
+		std::vector<std::vector<unsigned>>upper_neighbor(node_count);
+		for(unsigned u=0; u<node_count; ++u){
+			for(unsigned a=first_out[u]; a<first_out[u+1]; ++a){
+				unsigned x = rank[u], y = rank[head[a]];
+				if(x < y)
+					upper_neighbor[x].push_back(y);
+				else if(y < x)
+					upper_neighbor[y].push_back(x);
+			}
+		}
+
+		for(unsigned x=0; x<node_count; ++x){
+			auto&n = upper_neighbor[x];
+			std::sort(n.begin(), n.end());
+			n.erase(std::unique(n.begin(), n.end()), n.end());
+			if(!n.empty()){
+				unsigned p = n.front();
+				parent[x] = p;
+				std::vector<unsigned>merged;
+				std::set_union(n.begin()+1, n.end(), upper_neighbor[p].begin(), upper_neighbor[p].end(), std::back_inserter(merged));
+				upper_neighbor[p].swap(merged);
+			}
+		}
+
+		up_first_out.resize(node_count+1);
+		up_first_out[0] = 0;
+		for(unsigned x=0; x<node_count; ++x)
+			up_first_out[x+1] = up_first_out[x] + upper_neighbor[x].size();
+		up_head.reserve(up_first_out.back());
+		for(unsigned x=0; x<node_count; ++x){
+			up_head.insert(up_head.end(), upper_neighbor[x].begin(), upper_neighbor[x].end());
+			std::vector<unsigned>().swap(upper_neighbor[x]);
+		}
+
+		// The downward graph stores for every node y its lower neighbors sorted by rank.
+		const unsigned cch_arc_count = up_head.size();
+		down_first_out.assign(node_count+1, 0);
+		for(auto y:up_head)
+			++down_first_out[y+1];
+		for(unsigned y=0; y<node_count; ++y)
+			down_first_out[y+1] += down_first_out[y];
+		down_tail.resize(cch_arc_count);
+		down_to_up.resize(cch_arc_count);
+		std::vector<unsigned>next_down = down_first_out;
+		for(unsigned x=0; x<node_count; ++x){
+			for(unsigned a=up_first_out[x]; a<up_first_out[x+1]; ++a){
+				unsigned i = next_down[up_head[a]]++;
+				down_tail[i] = x;
+				down_to_up[i] = a;
+			}
+		}
+	}
+
+	void customize(){
+		const unsigned node_count = rank.size();
+		const unsigned cch_arc_count = up_head.size();
+
+		// up_plf[a] is the plf from the lower to the upper endpoint of a, down_plf[a] the reverse
+		std::vector<std::vector<IPP>>up_plf(cch_arc_count), down_plf(cch_arc_count);
+		std::vector<std::vector<unsigned>>up_input(cch_arc_count), down_input(cch_arc_count);
+
+		auto min_of = [&](const std::vector<IPP>&plf){
+			return plf.empty() ? inf_weight : minimum_of_plf(make_plf(period_, plf));
+		};
+
+		auto max_of = [&](const std::vector<IPP>&plf){
+			return plf.empty() ? inf_weight : maximum_of_plf(make_plf(period_, plf));
+		};
+
+		auto merge_into = [&](std::vector<IPP>&target, std::vector<IPP>candidate){
+			if(candidate.empty())
+				return;
+			if(target.empty() || max_of(candidate) <= min_of(target))
+				target = std::move(candidate);
+			else if(min_of(candidate) < max_of(target))
+				target = merge_plf(make_plf(period_, target), make_plf(period_, candidate));
+		};
+
+		// The link of f and g is dominated by target if its lower bound exceeds the upper bound of target.
+		auto link_and_merge_into = [&](std::vector<IPP>&target, const std::vector<IPP>&f, const std::vector<IPP>&g){
+			if(f.empty() || g.empty())
+				return;
+			if(!target.empty() && min_of(f) + min_of(g) >= max_of(target))
+				return;
+			merge_into(target, link_plf(make_plf(period_, f), make_plf(period_, g)));
+		};
+
+		for(unsigned u=0; u<node_count; ++u){
+			for(unsigned a=first_out[u]; a<first_out[u+1]; ++a){
+				unsigned x = rank[u], y = rank[head[a]];
+				if(x == y)
+					continue;
+				std::vector<IPP>plf;
+				for(unsigned i=first_ipp_of_arc[a]; i<first_ipp_of_arc[a+1]; ++i)
+					plf.push_back({ipp_departure_time[i], ipp_travel_time[i]});
+				if(x < y){
+					unsigned c = find_cch_arc(x, y);
+					merge_into(up_plf[c], std::move(plf));
+					up_input[c].push_back(a);
+				} else {
+					unsigned c = find_cch_arc(y, x);
+					merge_into(down_plf[c], std::move(plf));
+					down_input[c].push_back(a);
+				}
+			}
+		}
+
+		// Lower triangle enumeration: Processing the nodes z by increasing rank guarantees
+		// that the plfs of the arcs incident to z are final once z is reached.
+		for(unsigned z=0; z<node_count; ++z){
+			for(unsigned i=up_first_out[z]; i<up_first_out[z+1]; ++i){
+				for(unsigned j=i+1; j<up_first_out[z+1]; ++j){
+					unsigned c = find_cch_arc(up_head[i], up_head[j]);
+					// x -> z -> y with x = up_head[i] < y = up_head[j]
+					link_and_merge_into(up_plf[c], down_plf[i], up_plf[j]);
+					// y -> z -> x
+					link_and_merge_into(down_plf[c], down_plf[j], up_plf[i]);
+				}
+			}
+		}
+
+		auto flatten = [&](std::vector<std::vector<IPP>>&plf, std::vector<unsigned>&first_ipp, std::vector<IPP>&ipp){
+			first_ipp.resize(cch_arc_count+1);
+			first_ipp[0] = 0;
+			for(unsigned c=0; c<cch_arc_count; ++c)
+				first_ipp[c+1] = first_ipp[c] + plf[c].size();
+			ipp.reserve(first_ipp.back());
+			for(unsigned c=0; c<cch_arc_count; ++c){
+				ipp.insert(ipp.end(), plf[c].begin(), plf[c].end());
+				std::vector<IPP>().swap(plf[c]);
+			}
+		};
+		flatten(up_plf, first_up_ipp, up_ipp);
+		flatten(down_plf, first_down_ipp, down_ipp);
+
+		auto flatten_input = [&](std::vector<std::vector<unsigned>>&input, std::vector<unsigned>&first_input, std::vector<unsigned>&input_arc){
+			first_input.resize(cch_arc_count+1);
+			first_input[0] = 0;
+			for(unsigned c=0; c<cch_arc_count; ++c){
+				first_input[c+1] = first_input[c] + input[c].size();
+				input_arc.insert(input_arc.end(), input[c].begin(), input[c].end());
+			}
+		};
+		flatten_input(up_input, first_up_input_arc, up_input_arc);
+		flatten_input(down_input, first_down_input_arc, down_input_arc);
+	}
+
+	bool is_up_arc_finite(unsigned c)const{
+		return first_up_ipp[c] != first_up_ipp[c+1];
+	}
+
+	bool is_down_arc_finite(unsigned c)const{
+		return first_down_ipp[c] != first_down_ipp[c+1];
+	}
+
+	unsigned evaluate_up_arc(unsigned c, unsigned departure_time)const{
+		const IPP*ipp = up_ipp.data() + first_up_ipp[c];
+		return evaluate_plf(make_plf(period_, first_up_ipp[c+1] - first_up_ipp[c], [ipp](unsigned i){return ipp[i].departure_time;}, [ipp](unsigned i){return ipp[i].travel_time;}), departure_time % period_);
+	}
+
+	unsigned evaluate_down_arc(unsigned c, unsigned departure_time)const{
+		const IPP*ipp = down_ipp.data() + first_down_ipp[c];
+		return evaluate_plf(make_plf(period_, first_down_ipp[c+1] - first_down_ipp[c], [ipp](unsigned i){return ipp[i].departure_time;}, [ipp](unsigned i){return ipp[i].travel_time;}), departure_time % period_);
+	}
+
+	unsigned evaluate_input_arc(unsigned a, unsigned departure_time)const{
+		return evaluate_plf(ArcPLF(a, period_, first_ipp_of_arc, ipp_departure_time, ipp_travel_time), departure_time % period_);
+	}
+
+	unsigned period_;
+
+	std::vector<unsigned>rank;
+	std::vector<unsigned>parent;
+
+	std::vector<unsigned>up_first_out, up_head;
+	std::vector<unsigned>down_first_out, down_tail, down_to_up;
+
+	std::vector<unsigned>first_up_ipp, first_down_ipp;
+	std::vector<IPP>up_ipp, down_ipp;
+
+	std::vector<unsigned>first_up_input_arc, up_input_arc;
+	std::vector<unsigned>first_down_input_arc, down_input_arc;
+
+	const std::vector<unsigned>&first_out;
+	const std::vector<unsigned>&head;
+	const std::vector<unsigned>&first_ipp_of_arc;
+	const std::vector<unsigned>&ipp_departure_time;
+	const std::vector<unsigned>&ipp_travel_time;
+};
+
+//! Answers earliest arrival queries using an elimination tree search.
+//! First the arrival times at all ancestors of the source are computed using upward arcs.
+//! Then the ancestors of the target are processed top-down using downward arcs.
+class TimeDependentCCHQuery{
+public:
+	explicit TimeDependentCCHQuery(const TimeDependentCCH&cch):
+		cch(cch),
+		arrival_time(cch.node_count(), inf_weight),
+		predecessor(cch.node_count(), invalid_id),
+		source_rank(invalid_id),
+		target_rank(invalid_id){}
+
+	void run(unsigned source_node, unsigned source_time, unsigned target_node){
+		for(auto x:touched_rank)
+			arrival_time[x] = inf_weight;
+		touched_rank.clear();
+
+		source_rank = cch.rank[source_node];
+		target_rank = cch.rank[target_node];
+
+		arrival_time[source_rank] = source_time;
+		predecessor[source_rank] = invalid_id;
+		touched_rank.push_back(source_rank);
+
+		for(unsigned x = source_rank; x != invalid_id; x = cch.parent[x]){
+			if(arrival_time[x] == inf_weight)
+				continue;
+			for(unsigned c=cch.up_first_out[x]; c<cch.up_first_out[x+1]; ++c){
+				if(!cch.is_up_arc_finite(c))
+					continue;
+				unsigned y = cch.up_head[c];
+				unsigned t = arrival_time[x] + cch.evaluate_up_arc(c, arrival_time[x]);
+				if(t < arrival_time[y]){
+					if(arrival_time[y] == inf_weight)
+						touched_rank.push_back(y);
+					arrival_time[y] = t;
+					predecessor[y] = x;
+				}
+			}
+		}
+
+		target_ancestor.clear();
+		for(unsigned y = target_rank; y != invalid_id; y = cch.parent[y])
+			target_ancestor.push_back(y);
+
+		for(unsigned i=target_ancestor.size(); i>0; --i){
+			unsigned y = target_ancestor[i-1];
+			for(unsigned c=cch.up_first_out[y]; c<cch.up_first_out[y+1]; ++c){
+				unsigned x = cch.up_head[c];
+				if(arrival_time[x] == inf_weight || !cch.is_down_arc_finite(c))
+					continue;
+				unsigned t = arrival_time[x] + cch.evaluate_down_arc(c, arrival_time[x]);
+				if(t < arrival_time[y]){
+					if(arrival_time[y] == inf_weight)
+						touched_rank.push_back(y);
+					arrival_time[y] = t;
+					predecessor[y] = x;
+				}
+			}
+		}
+	}
+
+	//! The arrival time as computed by the hierarchy.
+	unsigned get_target_time()const{
+		return arrival_time[target_rank];
+	}
+
+	//! The path in terms of input arcs. The shortcuts are unpacked at the times at which they are traversed.
+	std::vector<unsigned>get_arc_path()const{
+		std::vector<unsigned>path;
+		if(arrival_time[target_rank] == inf_weight)
+			return path;
+
+		std::vector<unsigned>rank_path;
+		for(unsigned y = target_rank; y != source_rank; y = predecessor[y])
+			rank_path.push_back(y);
+		rank_path.push_back(source_rank);
+		std::reverse(rank_path.begin(), rank_path.end());
+
+		unsigned t = arrival_time[source_rank];
+		for(unsigned i=1; i<rank_path.size(); ++i)
+			t = unpack(rank_path[i-1], rank_path[i], t, path);
+		return path;
+	}
+
+private:
+	// Appends the input arcs of the cheapest x -> y connection departing at time t to path
+	// and returns the arrival time.
+	unsigned unpack(unsigned x, unsigned y, unsigned t, std::vector<unsigned>&path)const{
+		unsigned best_travel_time = inf_weight;
+		unsigned best_input_arc = invalid_id;
+		unsigned best_middle = invalid_id;
+
+		unsigned c = x < y ? cch.find_cch_arc(x, y) : cch.find_cch_arc(y, x);
+		if(x < y){
+			for(unsigned i=cch.first_up_input_arc[c]; i<cch.first_up_input_arc[c+1]; ++i){
+				unsigned a = cch.up_input_arc[i];
+				unsigned travel_time = cch.evaluate_input_arc(a, t);
+				if(travel_time < best_travel_time){
+					best_travel_time = travel_time;
+					best_input_arc = a;
+				}
+			}
+		} else {
+			for(unsigned i=cch.first_down_input_arc[c]; i<cch.first_down_input_arc[c+1]; ++i){
+				unsigned a = cch.down_input_arc[i];
+				unsigned travel_time = cch.evaluate_input_arc(a, t);
+				if(travel_time < best_travel_time){
+					best_travel_time = travel_time;
+					best_input_arc = a;
+				}
+			}
+		}
+
+		// Lower triangles x -> z -> y are the common lower neighbors z of x and y.
+		unsigned i = cch.down_first_out[x], i_end = cch.down_first_out[x+1];
+		unsigned j = cch.down_first_out[y], j_end = cch.down_first_out[y+1];
+		while(i != i_end && j != j_end){
+			if(cch.down_tail[i] < cch.down_tail[j]){
+				++i;
+			} else if(cch.down_tail[i] > cch.down_tail[j]){
+				++j;
+			} else {
+				unsigned xz = cch.down_to_up[i], zy = cch.down_to_up[j];
+				if(cch.is_down_arc_finite(xz) && cch.is_up_arc_finite(zy)){
+					unsigned first = cch.evaluate_down_arc(xz, t);
+					unsigned travel_time = first + cch.evaluate_up_arc(zy, t + first);
+					if(travel_time < best_travel_time){
+						best_travel_time = travel_time;
+						best_input_arc = invalid_id;
+						best_middle = cch.down_tail[i];
+					}
+				}
+				++i;
+				++j;
+			}
+		}
+
+		if(best_input_arc != invalid_id){
+			path.push_back(best_input_arc);
+			return t + best_travel_time;
+		} else {
+			assert(best_middle != invalid_id);
+			t = unpack(x, best_middle, t, path);
+			return unpack(best_middle, y, t, path);
+		}
+	}
+
+	const TimeDependentCCH&cch;
+
+	std::vector<unsigned>arrival_time;
+	std::vector<unsigned>predecessor;
+
+	std::vector<unsigned>touched_rank;
+	std::vector<unsigned>target_ancestor;
+
+	unsigned source_rank;
+	unsigned target_rank;
+};
+
+#endif
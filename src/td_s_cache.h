@@ -0,0 +1,92 @@
+#ifndef TD_S_CACHE_H
+#define TD_S_CACHE_H
+
+#include "lru_cache.h"
+
+#include <vector>
+
+//! Identifies a TD-S query up to the departure time bucket. The version must be changed
+//! whenever the arc weights change, for example, when a new realtime overlay is activated.
+//! Entries of old versions are never returned and are eventually evicted.
+struct TDSResultKey{
+	unsigned source_node;
+	unsigned target_node;
+	unsigned departure_time_bucket;
+	unsigned version;
+};
+
+inline
+bool operator==(const TDSResultKey&l, const TDSResultKey&r){
+	return l.source_node == r.source_node && l.target_node == r.target_node
+		&& l.departure_time_bucket == r.departure_time_bucket && l.version == r.version;
+}
+
+struct TDSResultKeyHash{
+	std::size_t operator()(const TDSResultKey&key)const{
+		unsigned long long h = key.source_node;
+		h = h * 0x100000001B3ull ^ key.target_node;
+		h = h * 0x100000001B3ull ^ key.departure_time_bucket;
+		h = h * 0x100000001B3ull ^ key.version;
+		return h;
+	}
+};
+
+//! The answer of a TD-S query. The target time refers to the departure time of the query that filled the entry.
+struct TDSResult{
+	unsigned target_time;
+	std::vector<unsigned>arc_path;
+};
+
+typedef ConcurrentLRUCache<TDSResultKey, TDSResult, TDSResultKeyHash> TDSResultCache;
+
+inline
+TDSResultKey make_td_s_result_key(unsigned source_node, unsigned target_node, unsigned departure_time, unsigned bucket_length, unsigned version){
+	return {source_node, target_node, departure_time / bucket_length, version};
+}
+
+//! Identifies the corridor of a TD-S query. The corridor does not depend on the departure time.
+struct TDSCorridorKey{
+	unsigned source_node;
+	unsigned target_node;
+};
+
+inline
+bool operator==(const TDSCorridorKey&l, const TDSCorridorKey&r){
+	return l.source_node == r.source_node && l.target_node == r.target_node;
+}
+
+struct TDSCorridorKeyHash{
+	std::size_t operator()(const TDSCorridorKey&key)const{
+		return static_cast<unsigned long long>(key.source_node) * 0x100000001B3ull ^ key.target_node;
+	}
+};
+
+//! The window CH paths of a TD-S query stored back to back. The arcs of path w are
+//! arc[first_arc_of_path[w]], ..., arc[first_arc_of_path[w+1]-1].
+struct TDSCorridor{
+	std::vector<unsigned>first_arc_of_path;
+	std::vector<unsigned>arc;
+};
+
+inline
+TDSCorridor make_td_s_corridor(const std::vector<std::vector<unsigned>>&path_list){
+	TDSCorridor corridor;
+	corridor.first_arc_of_path.reserve(path_list.size()+1);
+	corridor.first_arc_of_path.push_back(0);
+	for(auto&p:path_list){
+		corridor.arc.insert(corridor.arc.end(), p.begin(), p.end());
+		corridor.first_arc_of_path.push_back(corridor.arc.size());
+	}
+	return corridor; // NVRO
+}
+
+inline
+void extract_td_s_corridor_paths(const TDSCorridor&corridor, std::vector<std::vector<unsigned>>&path_list){
+	path_list.resize(corridor.first_arc_of_path.size()-1);
+	for(unsigned w=0; w<path_list.size(); ++w)
+		path_list[w].assign(corridor.arc.begin()+corridor.first_arc_of_path[w], corridor.arc.begin()+corridor.first_arc_of_path[w+1]);
+}
+
+typedef ConcurrentLRUCache<TDSCorridorKey, TDSCorridor, TDSCorridorKeyHash> TDSCorridorCache;
+
+#endif
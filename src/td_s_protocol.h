@@ -0,0 +1,100 @@
+#ifndef TD_S_PROTOCOL_H
+#define TD_S_PROTOCOL_H
+
+#include <vector>
+#include <cstring>
+
+// The binary protocol of run_td_s_daemon. A message is a frame consisting of its
+// payload size in bytes followed by the payload. All integers are 32-bit unsigned
+// integers in the byte order of the machine running the daemon.
+//
+// A request payload consists of
+//   request_id query_type source_node source_time target_node
+// where source_time is unused for TD-S+P. If the daemon was started with coordinates, a
+// request can instead give the source and target as coordinates using the payload
+//   request_id query_type source_latitude source_longitude source_time target_latitude target_longitude
+// where the latitudes and longitudes are 32-bit IEEE floats in degrees. They are snapped
+// to the nearest nodes. Such requests are invalid if the daemon has no coordinates.
+//
+// A response payload starts with
+//   request_id status
+// and is followed for TD-S and TD-S+D queries with status td_s_ok by
+//   target_time arc_count arc_0 ... arc_{arc_count-1}
+// and for TD-S+P queries with status td_s_ok by
+//   sample_step sample_count travel_time_0 ... travel_time_{sample_count-1}
+// where the i-th sample departs at i*sample_step and is inf_weight if there is no path at
+// this departure time. A TD-S+P query has status td_s_no_path only if no sample has a path.
+//
+// A client may send any number of requests without waiting for the responses.
+// Responses carry the request_id of their request and can arrive in any order.
+
+const unsigned td_s_max_frame_size = 1 << 20;
+const unsigned td_s_request_size = 5*sizeof(unsigned);
+const unsigned td_s_coordinate_request_size = 7*sizeof(unsigned);
+
+enum TDSQueryType : unsigned{
+	td_s_query = 0,
+	td_s_p_query = 1,
+	td_s_d_query = 2
+};
+
+enum TDSResponseStatus : unsigned{
+	td_s_ok = 0,
+	td_s_no_path = 1,
+	td_s_invalid_request = 2,
+	td_s_unsupported_query_type = 3
+};
+
+struct TDSRequest{
+	unsigned request_id;
+	unsigned query_type;
+	unsigned source_node;
+	unsigned source_time;
+	unsigned target_node;
+};
+
+struct TDSCoordinateRequest{
+	unsigned request_id;
+	unsigned query_type;
+	float source_latitude;
+	float source_longitude;
+	unsigned source_time;
+	float target_latitude;
+	float target_longitude;
+};
+
+static_assert(sizeof(float) == sizeof(unsigned), "coordinates must be 32-bit floats");
+
+//! payload must point to td_s_request_size bytes.
+inline
+TDSRequest decode_td_s_request(const char*payload){
+	unsigned x[5];
+	std::memcpy(x, payload, td_s_request_size);
+	return {x[0], x[1], x[2], x[3], x[4]};
+}
+
+//! payload must point to td_s_coordinate_request_size bytes.
+inline
+TDSCoordinateRequest decode_td_s_coordinate_request(const char*payload){
+	TDSCoordinateRequest r;
+	const unsigned size = sizeof(unsigned);
+	std::memcpy(&r.request_id, payload, size);
+	std::memcpy(&r.query_type, payload + size, size);
+	std::memcpy(&r.source_latitude, payload + 2*size, size);
+	std::memcpy(&r.source_longitude, payload + 3*size, size);
+	std::memcpy(&r.source_time, payload + 4*size, size);
+	std::memcpy(&r.target_latitude, payload + 5*size, size);
+	std::memcpy(&r.target_longitude, payload + 6*size, size);
+	return r;
+}
+
+//! Appends a response frame with the given body to out.
+inline
+void append_td_s_response(std::vector<unsigned>&out, unsigned request_id, TDSResponseStatus status, const std::vector<unsigned>&body = {}){
+	out.push_back((2 + body.size())*sizeof(unsigned));
+	out.push_back(request_id);
+	out.push_back(status);
+	out.insert(out.end(), body.begin(), body.end());
+}
+
+#endif
@@ -0,0 +1,189 @@
+#ifndef VECTOR_STREAM_H
+#define VECTOR_STREAM_H
+
+#include <vector>
+#include <string>
+#include <future>
+#include <stdexcept>
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+//! Chunk sizes are rounded up to a multiple of this many bytes, so that every read starts at a page boundary.
+const unsigned long long vector_stream_alignment = 1 << 16;
+
+//! Reads a file written by RoutingKit::save_vector element by element without loading it completely.
+//! The file is read in chunks. While the elements of one chunk are consumed, the next chunk
+//! is read in the background. At most two chunks are in memory at any time.
+template<class T>
+class VectorStreamReader{
+public:
+	VectorStreamReader(const std::string&file_name, unsigned long long chunk_size_in_bytes):
+		file_name(file_name), next_offset(0), pos(0){
+		fd = open(file_name.c_str(), O_RDONLY);
+		if(fd < 0)
+			throw std::runtime_error("Can not open \""+file_name+"\" for reading.");
+		struct stat s;
+		if(fstat(fd, &s) != 0){
+			close(fd);
+			throw std::runtime_error("Can not determine the size of \""+file_name+"\".");
+		}
+		if(s.st_size % sizeof(T) != 0){
+			close(fd);
+			throw std::runtime_error("The size of \""+file_name+"\" is not a multiple of the element size.");
+		}
+		file_size = s.st_size;
+		posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+		unsigned long long aligned = (chunk_size_in_bytes + vector_stream_alignment - 1) / vector_stream_alignment * vector_stream_alignment;
+		// The alignment is a multiple of sizeof(T) for all element types used with this class.
+		static_assert(vector_stream_alignment % sizeof(T) == 0, "the element size must divide the alignment");
+		chunk_element_count = std::max(aligned, vector_stream_alignment) / sizeof(T);
+
+		current.reserve(chunk_element_count);
+		start_read_ahead();
+	}
+
+	~VectorStreamReader(){
+		if(read_ahead.valid())
+			read_ahead.wait();
+		close(fd);
+	}
+
+	VectorStreamReader(const VectorStreamReader&) = delete;
+	VectorStreamReader&operator=(const VectorStreamReader&) = delete;
+
+	//! The number of elements in the file.
+	unsigned long long size()const{
+		return file_size / sizeof(T);
+	}
+
+	//! Returns whether there is a further element.
+	bool has_next(){
+		if(pos == current.size())
+			fetch_next_chunk();
+		return pos != current.size();
+	}
+
+	//! Returns the next element. Must only be called if has_next() returns true.
+	T next(){
+		if(pos == current.size())
+			fetch_next_chunk();
+		assert(pos < current.size());
+		return current[pos++];
+	}
+
+private:
+	void start_read_ahead(){
+		if(next_offset == file_size)
+			return;
+		unsigned long long offset = next_offset;
+		unsigned long long byte_count = std::min(chunk_element_count*sizeof(T), file_size - offset);
+		next_offset += byte_count;
+		read_ahead = std::async(std::launch::async, [this, offset, byte_count]{
+			std::vector<T>buffer(byte_count / sizeof(T));
+			char*data = reinterpret_cast<char*>(buffer.data());
+			unsigned long long done = 0;
+			while(done != byte_count){
+				ssize_t r = pread(fd, data + done, byte_count - done, offset + done);
+				if(r <= 0)
+					throw std::runtime_error("Can not read from \""+file_name+"\".");
+				done += r;
+			}
+			return buffer; // NVRO
+		});
+	}
+
+	void fetch_next_chunk(){
+		if(!read_ahead.valid()){
+			current.clear();
+			pos = 0;
+			return;
+		}
+		current = read_ahead.get();
+		pos = 0;
+		start_read_ahead();
+	}
+
+	std::string file_name;
+	int fd;
+	unsigned long long file_size;
+	unsigned long long chunk_element_count;
+	unsigned long long next_offset;
+
+	std::vector<T>current;
+	unsigned long long pos;
+	std::future<std::vector<T>>read_ahead;
+};
+
+//! Writes a file that can be read by RoutingKit::load_vector element by element.
+//! The elements are buffered and written to disk whenever a chunk is full. They go to a temporary
+//! file next to file_name that only replaces file_name when finish is called.
+template<class T>
+class VectorStreamWriter{
+public:
+	VectorStreamWriter(const std::string&file_name, unsigned long long chunk_size_in_bytes):
+		file_name(file_name), temporary_file_name(file_name+".tmp"){
+		fd = open(temporary_file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if(fd < 0)
+			throw std::runtime_error("Can not open \""+temporary_file_name+"\" for writing.");
+		chunk_element_count = std::max(1ull, chunk_size_in_bytes / sizeof(T));
+		buffer.reserve(chunk_element_count);
+	}
+
+	//! If finish was not called, the partially written file is removed and file_name is left untouched.
+	~VectorStreamWriter(){
+		if(fd >= 0){
+			close(fd);
+			unlink(temporary_file_name.c_str());
+		}
+	}
+
+	VectorStreamWriter(const VectorStreamWriter&) = delete;
+	VectorStreamWriter&operator=(const VectorStreamWriter&) = delete;
+
+	void push_back(T x){
+		buffer.push_back(x);
+		if(buffer.size() == chunk_element_count)
+			flush();
+	}
+
+	//! Writes all buffered elements, closes the file, and moves it to file_name.
+	void finish(){
+		flush();
+		int r = close(fd);
+		fd = -1;
+		if(r != 0){
+			unlink(temporary_file_name.c_str());
+			throw std::runtime_error("Can not close \""+temporary_file_name+"\".");
+		}
+		if(std::rename(temporary_file_name.c_str(), file_name.c_str()) != 0){
+			unlink(temporary_file_name.c_str());
+			throw std::runtime_error("Can not rename \""+temporary_file_name+"\" to \""+file_name+"\".");
+		}
+	}
+
+private:
+	void flush(){
+		const char*data = reinterpret_cast<const char*>(buffer.data());
+		unsigned long long byte_count = buffer.size()*sizeof(T), done = 0;
+		while(done != byte_count){
+			ssize_t r = write(fd, data + done, byte_count - done);
+			if(r <= 0)
+				throw std::runtime_error("Can not write to \""+temporary_file_name+"\".");
+			done += r;
+		}
+		buffer.clear();
+	}
+
+	std::string file_name, temporary_file_name;
+	int fd;
+	unsigned long long chunk_element_count;
+	std::vector<T>buffer;
+};
+
+#endif